@@ -0,0 +1,69 @@
+#!/usr/bin/env bash
+# Copyright Epic Games, Inc. All Rights Reserved.
+#
+# Soak test on one Linux box: a -nullrhi dedicated server plus N headless clients
+# that play themselves through UVRiCCBotComponent.
+#
+#   Scripts/RunBotSoak.sh [NumBots=16] [DurationSeconds=600] [Behavior=Random|Scripted]
+#
+# SERVER_BIN and CLIENT_BIN default to running the project through UnrealEditor from UE_ROOT,
+# point them at packaged binaries to soak a cooked build, e.g. SERVER_BIN=.../LinuxServer/VRiCCServer.sh
+# for the VRiCCServer target. The server writes its report to
+# Saved/Soak/ and quits after the duration, the bots are stopped with it.
+
+set -euo pipefail
+
+NUM_BOTS="${1:-16}"
+DURATION="${2:-600}"
+BEHAVIOR="${3:-Random}"
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="${PROJECT_DIR}/VRiCC.uproject"
+MAP="${MAP:-/Game/FirstPerson/Maps/FirstPersonMap}"
+PORT="${PORT:-7777}"
+LOG_DIR="${LOG_DIR:-${PROJECT_DIR}/Saved/Logs/Soak}"
+
+if [[ -n "${UE_ROOT:-}" ]]; then
+	EDITOR="${UE_ROOT}/Engine/Binaries/Linux/UnrealEditor"
+	SERVER_BIN="${SERVER_BIN:-${EDITOR} ${PROJECT}}"
+	CLIENT_BIN="${CLIENT_BIN:-${EDITOR} ${PROJECT}}"
+fi
+
+if [[ -z "${SERVER_BIN:-}" || -z "${CLIENT_BIN:-}" ]]; then
+	echo "Set UE_ROOT, or SERVER_BIN and CLIENT_BIN" >&2
+	exit 1
+fi
+
+mkdir -p "${LOG_DIR}"
+
+PIDS=()
+cleanup()
+{
+	for PID in "${PIDS[@]}"; do
+		kill "${PID}" 2>/dev/null || true
+	done
+}
+trap cleanup EXIT
+
+# shellcheck disable=SC2086
+${SERVER_BIN} "${MAP}" -server -nullrhi -nosound -unattended -port="${PORT}" \
+	-VRiCCSoak -VRiCCSoakDuration="${DURATION}" \
+	-log -abslog="${LOG_DIR}/Server.log" &
+SERVER_PID=$!
+PIDS+=("${SERVER_PID}")
+
+# give the server time to load the map before the first connection
+sleep "${SERVER_STARTUP_SECONDS:-20}"
+
+for ((BOT = 0; BOT < NUM_BOTS; BOT++)); do
+	# shellcheck disable=SC2086
+	${CLIENT_BIN} "127.0.0.1:${PORT}" -game -nullrhi -nosound -unattended -windowed -ResX=64 -ResY=64 \
+		-VRiCCBot -VRiCCBotBehavior="${BEHAVIOR}" -VRiCCBotSeed="${BOT}" \
+		-log -abslog="${LOG_DIR}/Bot${BOT}.log" &
+	PIDS+=("$!")
+	sleep "${BOT_SPAWN_INTERVAL:-0.5}"
+done
+
+echo "Soak: ${NUM_BOTS} bots for ${DURATION}s, logs in ${LOG_DIR}"
+wait "${SERVER_PID}" || true
+grep "Soak" "${LOG_DIR}/Server.log" || true
@@ -0,0 +1,44 @@
+#!/usr/bin/env bash
+# Copyright Epic Games, Inc. All Rights Reserved.
+#
+# Replays an input recording on a -nullrhi standalone game at a fixed timestep, as a repeatable benchmark
+# or to reproduce a hitch. Record one in game with VRiCC.Input.Record / VRiCC.Input.Stop, or start the
+# game with -VRiCCRecordInput; add -benchmark -fps=60 to record at the timestep it replays at.
+#
+#   Scripts/RunInputReplay.sh Recording.vrir [Hz=recorded]
+#
+# GAME_BIN defaults to running the project through UnrealEditor from UE_ROOT. The replay logs its frame
+# times, the frame of its worst hitch and whether the character ended up where the recording says.
+
+set -euo pipefail
+
+RECORDING="${1:?Usage: RunInputReplay.sh Recording.vrir [Hz]}"
+HZ="${2:-}"
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="${PROJECT_DIR}/VRiCC.uproject"
+MAP="${MAP:-/Game/FirstPerson/Maps/FirstPersonMap}"
+LOG_DIR="${LOG_DIR:-${PROJECT_DIR}/Saved/Logs/InputReplay}"
+
+if [[ -n "${UE_ROOT:-}" ]]; then
+	GAME_BIN="${GAME_BIN:-${UE_ROOT}/Engine/Binaries/Linux/UnrealEditor ${PROJECT}}"
+fi
+
+if [[ -z "${GAME_BIN:-}" ]]; then
+	echo "Set UE_ROOT or GAME_BIN" >&2
+	exit 1
+fi
+
+mkdir -p "${LOG_DIR}"
+
+EXTRA_ARGS=()
+if [[ -n "${HZ}" ]]; then
+	EXTRA_ARGS+=("-VRiCCReplayHz=${HZ}")
+fi
+
+# shellcheck disable=SC2086
+${GAME_BIN} "${MAP}" -game -nullrhi -nosound -unattended -windowed -ResX=64 -ResY=64 \
+	-VRiCCReplayInput="$(realpath "${RECORDING}")" ${EXTRA_ARGS[@]+"${EXTRA_ARGS[@]}"} \
+	-log -abslog="${LOG_DIR}/InputReplay.log"
+
+grep "Input:" "${LOG_DIR}/InputReplay.log" || true
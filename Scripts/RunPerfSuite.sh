@@ -0,0 +1,57 @@
+#!/usr/bin/env bash
+# Copyright Epic Games, Inc. All Rights Reserved.
+#
+# Performance regression suite on one Linux box: a -nullrhi standalone game that spawns scripted
+# AVRiCCCharacter shooters and measures firing, projectiles, pickups and damage at each scale.
+#
+#   Scripts/RunPerfSuite.sh [Scales=1,16,64,256] [WriteBaseline=0|1]
+#
+# GAME_BIN defaults to running the project through UnrealEditor from UE_ROOT, point it at a packaged
+# binary to measure a cooked build. Results are written to Saved/Perf/ and compared with BASELINE
+# (default Saved/Perf/Baseline.json). The script exits with 1 when a hot path got slower than the
+# baseline by more than THRESHOLD (default VRiCC.PerfSuite.Threshold), and refuses to run without a
+# baseline unless WriteBaseline=1 creates one.
+
+set -euo pipefail
+
+SCALES="${1:-1,16,64,256}"
+WRITE_BASELINE="${2:-0}"
+
+PROJECT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+PROJECT="${PROJECT_DIR}/VRiCC.uproject"
+MAP="${MAP:-/Game/FirstPerson/Maps/FirstPersonMap}"
+LOG_DIR="${LOG_DIR:-${PROJECT_DIR}/Saved/Logs/Perf}"
+BASELINE="${BASELINE:-${PROJECT_DIR}/Saved/Perf/Baseline.json}"
+
+if [[ -n "${UE_ROOT:-}" ]]; then
+	GAME_BIN="${GAME_BIN:-${UE_ROOT}/Engine/Binaries/Linux/UnrealEditor ${PROJECT}}"
+fi
+
+if [[ -z "${GAME_BIN:-}" ]]; then
+	echo "Set UE_ROOT or GAME_BIN" >&2
+	exit 1
+fi
+
+if [[ "${WRITE_BASELINE}" != "1" && ! -f "${BASELINE}" ]]; then
+	echo "No baseline at ${BASELINE}, run with WriteBaseline=1 first" >&2
+	exit 1
+fi
+
+mkdir -p "${LOG_DIR}"
+
+EXTRA_ARGS=()
+if [[ "${WRITE_BASELINE}" == "1" ]]; then
+	EXTRA_ARGS+=("-VRiCCPerfWriteBaseline")
+fi
+if [[ -n "${THRESHOLD:-}" ]]; then
+	EXTRA_ARGS+=("-VRiCCPerfThreshold=${THRESHOLD}")
+fi
+
+STATUS=0
+# shellcheck disable=SC2086
+${GAME_BIN} "${MAP}" -game -nullrhi -nosound -unattended -NoVSync \
+	-VRiCCPerfSuite -VRiCCStartupReport -VRiCCPerfScales="${SCALES}" -VRiCCPerfBaseline="${BASELINE}" ${EXTRA_ARGS[@]+"${EXTRA_ARGS[@]}"} \
+	-log -abslog="${LOG_DIR}/PerfSuite.log" || STATUS=$?
+
+grep "PerfSuite" "${LOG_DIR}/PerfSuite.log" || true
+exit "${STATUS}"
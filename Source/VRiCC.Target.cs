@@ -10,6 +10,7 @@ public class VRiCCTarget : TargetRules
 		Type = TargetType.Game;
 		DefaultBuildSettings = BuildSettingsVersion.V4;
 		IncludeOrderVersion = EngineIncludeOrderVersion.Unreal5_3;
+		bWithPushModel = true;
 		ExtraModuleNames.Add("VRiCC");
 	}
 }
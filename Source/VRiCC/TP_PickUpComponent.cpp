@@ -1,8 +1,8 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "TP_PickUpComponent.h"
+#include "VRiCCStats.h"
 #include "WeaponSpawner.h"
-#include <Kismet/GameplayStatics.h>
 
 UTP_PickUpComponent::UTP_PickUpComponent()
 {
@@ -17,10 +17,21 @@ void UTP_PickUpComponent::BeginPlay()
 
 	// Register our Overlap Event
 	OnComponentBeginOverlap.AddDynamic(this, &UTP_PickUpComponent::OnSphereBeginOverlap);
+
+	// an owning spawner is known now, the nearest one only once every spawner has registered
+	ResolveSpawnerHandle(false);
+
+	// a pickup lying around has nothing to replicate until someone picks it up
+	if (GetOwner()->HasAuthority())
+	{
+		GetOwner()->SetNetDormancy(DORM_DormantAll);
+	}
 }
 
 void UTP_PickUpComponent::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
 {
+	VRICC_SCOPE_CYCLE(PickupOverlap);
+
 	// Checking if it is a First Person Character overlapping
 	AVRiCCCharacter* Character = Cast<AVRiCCCharacter>(OtherActor);
 	if(Character != nullptr && Character->GetHasRifle() == false && Entered == false)
@@ -32,13 +43,45 @@ void UTP_PickUpComponent::OnSphereBeginOverlap(UPrimitiveComponent* OverlappedCo
 		// Unregister from the Overlap Event so it is no longer triggered
 		OnComponentBeginOverlap.RemoveAll(this);
 
-		TArray<AActor*> FoundActors;
-		UGameplayStatics::GetAllActorsOfClass(GetWorld(), AWeaponSpawner::StaticClass(), FoundActors);
-		if (FoundActors.Num() > 0)
+		// carried weapons move with their character
+		if (GetOwner()->HasAuthority())
 		{
-			AWeaponSpawner* spawner = Cast<AWeaponSpawner>(FoundActors[0]);
-			spawner->OnPickUpWeapon.Broadcast();
+			GetOwner()->SetNetDormancy(DORM_Awake);
 		}
-		
+
+		// Notify the spawner this pickup came from
+		ResolveSpawnerHandle(true);
+		if (UVRiCCSpawnerRegistry* SpawnerRegistry = GetWorld()->GetSubsystem<UVRiCCSpawnerRegistry>())
+		{
+			if (AWeaponSpawner* Spawner = SpawnerRegistry->Resolve(SpawnerHandle))
+			{
+				Spawner->NotifyPickedUp();
+			}
+		}
+	}
+}
+
+void UTP_PickUpComponent::ResolveSpawnerHandle(bool bFindNearest)
+{
+	if (SpawnerHandle.IsValid())
+	{
+		return;
+	}
+
+	// spawned by a spawner that did not go through AWeaponSpawner::SpawnWeapon
+	if (const AWeaponSpawner* OwningSpawner = Cast<AWeaponSpawner>(GetOwner()->GetOwner()))
+	{
+		SpawnerHandle = OwningSpawner->GetSpawnerHandle();
+		return;
+	}
+
+	// placed or spawned without an owner, the closest spawner is the one it belongs to
+	if (!bFindNearest)
+	{
+		return;
+	}
+	if (const UVRiCCSpawnerRegistry* SpawnerRegistry = GetWorld()->GetSubsystem<UVRiCCSpawnerRegistry>())
+	{
+		SpawnerHandle = SpawnerRegistry->FindNearest(GetComponentLocation());
 	}
 }
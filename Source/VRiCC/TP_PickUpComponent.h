@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Components/SphereComponent.h"
 #include "VRiCCCharacter.h"
+#include "VRiCCSpawnerRegistry.h"
 #include "TP_PickUpComponent.generated.h"
 
 // Declaration of the delegate that will be called when someone picks this up
@@ -23,6 +24,10 @@ public:
 	FOnPickUp OnPickUp;
 
 	UTP_PickUpComponent();
+
+	/** Spawner notified when this is picked up */
+	void SetSpawnerHandle(const FVRiCCSpawnerHandle& Handle) { SpawnerHandle = Handle; }
+
 protected:
 
 	/** Called when the game starts */
@@ -32,5 +37,10 @@ protected:
 	UFUNCTION()
 	void OnSphereBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
 
+	/** Finds the spawner this pickup belongs to if no spawner handed us its handle, bFindNearest falls back to the closest registered one */
+	void ResolveSpawnerHandle(bool bFindNearest);
+
 	bool Entered;
+
+	FVRiCCSpawnerHandle SpawnerHandle;
 };
\ No newline at end of file
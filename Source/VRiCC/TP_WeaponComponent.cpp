@@ -2,23 +2,171 @@
 
 
 #include "TP_WeaponComponent.h"
+#include "VRiCC.h"
+#include "VRiCCDamage.h"
+#include "VRiCCHUDModel.h"
+#include "VRiCCImpactEffects.h"
 #include "VRiCCProjectile.h"
+#include "VRiCCProjectilePool.h"
+#include "VRiCCProjectileManager.h"
+#include "VRiCCLagCompensation.h"
+#include "VRiCCShotDebug.h"
+#include "VRiCCShotResolver.h"
+#include "VRiCCStats.h"
+#include "VRiCCTraceQueue.h"
+#include "VRiCCWeaponAudio.h"
 #include "GameFramework/PlayerController.h"
+#include "GameFramework/GameStateBase.h"
 #include "Camera/PlayerCameraManager.h"
-#include "Kismet/GameplayStatics.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
-#include "DrawDebugHelpers.h"
 #include "Camera/CameraComponent.h"
 #include "Engine/EngineTypes.h"
-#include "Engine/DamageEvents.h"
+#include "EngineUtils.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarFirePacketFlushInterval(
+	TEXT("VRiCC.FirePacket.FlushInterval"),
+	0.f,
+	TEXT("Seconds a client collects shots before sending them in one packet, 0 sends the shots of every frame right away."));
+
+static TAutoConsoleVariable<float> CVarFirePacketMaxOriginError(
+	TEXT("VRiCC.FirePacket.MaxOriginError"),
+	250.f,
+	TEXT("Farthest a shot origin may be from the firing character on the server before the shot is rejected."));
+
+static TAutoConsoleVariable<float> CVarFirePacketMinRoundsPerMinute(
+	TEXT("VRiCC.FirePacket.MinRoundsPerMinute"),
+	600.f,
+	TEXT("Lowest fire rate the server allows per weapon, covers single fire clicked faster than the automatic rate."));
+
+static TAutoConsoleVariable<float> CVarFirePacketBurstSeconds(
+	TEXT("VRiCC.FirePacket.BurstSeconds"),
+	0.5f,
+	TEXT("Seconds of fire the server lets a client bank, absorbs packets bunched up by network jitter."));
+
+static FAutoConsoleCommandWithWorld GFirePacketStatsCommand(
+	TEXT("VRiCC.FirePacket.Stats"),
+	TEXT("Prints the fire packets the server received and how many shots it accepted, rate limited and rejected."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		FVRiCCFirePacketStats Total;
+		for (TActorIterator<AVRiCCCharacter> It(World); It; ++It)
+		{
+			if (const UTP_WeaponComponent* Weapon = It->GetWeapon())
+			{
+				const FVRiCCFirePacketStats& Stats = Weapon->GetFirePacketStats();
+				Total.Packets += Stats.Packets;
+				Total.AcceptedShots += Stats.AcceptedShots;
+				Total.RateLimitedShots += Stats.RateLimitedShots;
+				Total.RejectedShots += Stats.RejectedShots;
+				Total.OutOfAmmoShots += Stats.OutOfAmmoShots;
+			}
+		}
+		UE_LOG(LogTemp, Display, TEXT("FirePacket: packets %llu, accepted %llu, rate limited %llu, rejected %llu, out of ammo %llu"),
+			Total.Packets, Total.AcceptedShots, Total.RateLimitedShots, Total.RejectedShots, Total.OutOfAmmoShots);
+	}));
+
+static FAutoConsoleCommandWithWorld GAmmoPredictionStatsCommand(
+	TEXT("VRiCC.Weapon.PredictionStats"),
+	TEXT("Prints the ammo changes of the local weapon still waiting for a server ack and how often the prediction was corrected."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const APlayerController* PlayerController = World != nullptr ? World->GetFirstPlayerController() : nullptr;
+		const AVRiCCCharacter* Character = PlayerController != nullptr ? Cast<AVRiCCCharacter>(PlayerController->GetPawn()) : nullptr;
+		if (const UTP_WeaponComponent* Weapon = Character != nullptr ? Character->GetWeapon() : nullptr)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Weapon prediction: acked sequence %u, mispredictions %llu"),
+				Character->GetAmmoAckSequence(), Weapon->GetAmmoMispredictions());
+		}
+	}));
+
+namespace VRiCCWeapon
+{
+	/** Predicted changes kept at most, older ones are dropped if the server stops acknowledging */
+	static constexpr int32 MaxPendingAmmoChanges = 64;
+
+	/** True if sequence A comes after B, sequence numbers wrap around */
+	static bool IsSequenceNewer(uint16 A, uint16 B)
+	{
+		return int16(A - B) > 0;
+	}
+}
 
 // Sets default values for this component's properties
 UTP_WeaponComponent::UTP_WeaponComponent()
 {
 	// Default offset from the character location for projectiles to spawn
 	MuzzleOffset = FVector(100.0f, 0.0f, 10.0f);
+	bFiresProjectiles = false;
+	ProjectilePoolSize = 16;
 	_FiringMode = FiringMode::FiringMode_Single;
+
+	// automatic shots at the rate of the weapon stats, scheduled from TickComponent
+	PrimaryComponentTick.bCanEverTick = true;
+	bAutoFireHeld = false;
+	AutoFireAccumulator = 0.0;
+	PendingFirePacketTime = 0.0;
+	FireTokens = -1.0;
+	FireTokensTime = 0.0;
+	LastAcceptedShotTime = 0.0;
+	AmmoSequence = 0;
+	AmmoMispredictions = 0;
+	ShotsFired = 0;
+	WeaponId = FVRiCCWeaponTable::DefaultWeaponId;
+}
+
+void UTP_WeaponComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// compiled here if the asset manager did not load the definition at startup
+	WeaponId = FVRiCCWeaponTable::FindOrAdd(Definition);
+
+	// the definition's cosmetics replace the ones set on the component, they still only stream in on pickup
+	if (Definition != nullptr)
+	{
+		FireSound = Definition->FireSound;
+		ReloadSound = Definition->ReloadSound;
+		EmptySound = Definition->EmptySound;
+		FireLoopSound = Definition->FireLoopSound;
+		FireTailSound = Definition->FireTailSound;
+		FireAnimation = Definition->FireAnimation;
+	}
+}
+
+void UTP_WeaponComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	// the last shots of a burst go out once the flush interval ran out, even if no more follow
+	if (PendingFirePacket.Num() > 0 && GetWorld()->GetTimeSeconds() - PendingFirePacketTime >= CVarFirePacketFlushInterval.GetValueOnGameThread())
+	{
+		FlushFirePacket();
+	}
+
+	if (!bAutoFireHeld || Character == nullptr)
+	{
+		return;
+	}
+
+	// every shot whose time came within this frame, however many that are, so the count never depends on the frame rate
+	const double Interval = GetStats().ShotInterval;
+	AutoFireAccumulator += DeltaTime;
+
+	DueShotAges.Reset();
+	while (AutoFireAccumulator >= Interval)
+	{
+		AutoFireAccumulator -= Interval;
+		DueShotAges.Add(AutoFireAccumulator);
+	}
+
+	if (DueShotAges.Num() > 0)
+	{
+		FireShots(DueShotAges);
+	}
 }
 
 // press/hold fire main method
@@ -45,8 +193,13 @@ void UTP_WeaponComponent::Fire()
 		}
 
 		// out of ammo
-		GetWorld()->GetTimerManager().ClearTimer(AutoFireTimerHandle);
-		UGameplayStatics::PlaySoundAtLocation(this, EmptySound, Character->GetActorLocation());
+		FireStop();
+#if VRICC_WITH_PRESENTATION
+		if (UVRiCCWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UVRiCCWeaponAudioSubsystem>())
+		{
+			WeaponAudio->PlaySound(this, EmptySound.Get(), Character->GetActorLocation());
+		}
+#endif
 		return;
 	}
 
@@ -59,104 +212,491 @@ void UTP_WeaponComponent::Fire()
 
 }
 
-// call timer for auto fire
+// start the auto fire schedule, the first shot is due one interval after the press
 void UTP_WeaponComponent::AutoFire()
 {
 	if (_FiringMode == FiringMode::FiringMode_Auto)
 	{
-		GetWorld()->GetTimerManager().SetTimer(AutoFireTimerHandle, this, &UTP_WeaponComponent::FireAndHit, 0.5, true);
-
+		bAutoFireHeld = true;
+		AutoFireAccumulator = 0.0;
 	}
 }
 
 // released fire input, stop auto fire
 void UTP_WeaponComponent::FireStop()
 {
-	GetWorld()->GetTimerManager().ClearTimer(AutoFireTimerHandle);
+	bAutoFireHeld = false;
+
+#if VRICC_WITH_PRESENTATION
+	if (UVRiCCWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UVRiCCWeaponAudioSubsystem>())
+	{
+		WeaponAudio->StopFireLoop(this, FireTailSound.Get());
+	}
+#endif
 }
 
 void UTP_WeaponComponent::FireAndHit()
 {
+	const double ShotAge = 0.0;
+	FireShots(MakeArrayView(&ShotAge, 1));
+}
+
+void UTP_WeaponComponent::FireShots(TConstArrayView<double> ShotAges)
+{
+	VRICC_SCOPE_CYCLE(FireShots);
+
 	// if called by autofire, return when weapon is out, player can reload with click
 	if (_FiringMode == FiringMode::FiringMode_Auto && Character->VRiCC_ShotsLeft == 0)
 	{
 		FireStop();
 		return;
 	}
-	
-	
-	Character->VRiCC_ShotsLeft--;
+
+	// the oldest shots of the batch are the ones the magazine still has rounds for
+	const int32 NumShots = FMath::Min(ShotAges.Num(), Character->VRiCC_ShotsLeft);
+	if (NumShots <= 0)
+	{
+		return;
+	}
+	ShotAges = ShotAges.Slice(0, NumShots);
+	VRICC_COUNT(Shots, NumShots);
+	ShotsFired += NumShots;
+
+	// the owning client spends the ammo right away, the server confirms it per packet in QueueServerShots
+	Character->VRiCC_ShotsLeft -= NumShots;
+	if (Character->HasAuthority())
+	{
+		Character->CommitCombatState();
+	}
 	Character->ShowAmmoInfo(_FiringMode);
 
-	// line trace: TC_Weapon trace channel check - ECC_GameTraceChannel1
-	FHitResult OutHit;
-	const FRotator SpawnRotation = Character->GetControlRotation();
+	// projectile weapons launch a pooled projectile, everything else is hitscan
+	if (bFiresProjectiles && ProjectileClass != nullptr)
+	{
+		FireProjectiles(ShotAges);
+	}
+	else
+	{
+		FireTrace(ShotAges);
+	}
+
+#if VRICC_WITH_PRESENTATION
+	if (VRiCC::IsPresentationEnabled(this))
+	{
+		// held automatic fire collapses into one looped voice, everything else is a pooled one shot
+		if (UVRiCCWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UVRiCCWeaponAudioSubsystem>())
+		{
+			USoundBase* LoopSound = FireLoopSound.Get();
+			if (bAutoFireHeld && LoopSound != nullptr)
+			{
+				WeaponAudio->StartFireLoop(this, LoopSound);
+			}
+			else
+			{
+				WeaponAudio->PlaySound(this, FireSound.Get(), Character->GetActorLocation());
+			}
+		}
+
+		// Try and play a firing animation if specified
+		if (UAnimMontage* FireMontage = FireAnimation.Get())
+		{
+			// Get the animation object for the arms mesh
+			UAnimInstance* AnimInstance = Character->GetMesh1P()->GetAnimInstance();
+			if (AnimInstance != nullptr)
+			{
+				AnimInstance->Montage_Play(FireMontage, 1.f);
+			}
+		}
+	}
+#endif
+}
+
+// hitscan shots along the barrel, all from the muzzle pose of this frame
+void UTP_WeaponComponent::FireTrace(TConstArrayView<double> ShotAges)
+{
 	const FVector MuzzlePos = GetSocketLocation("Muzzle");
 	FVector ForwardVector = GetSocketRotation("GripPoint").Vector() * -1.0f;
 	const FVector Start = MuzzlePos + (ForwardVector * 5.0f);
+	const FVector End = ((ForwardVector * GetStats().TraceLength) + Start);
 
-	FVector End = ((ForwardVector * 1000.f) + Start);
-	FCollisionQueryParams CollisionParams;
-	FCollisionObjectQueryParams CollObjects;
-	CollisionParams.AddIgnoredActor(Character);
+	// shot times in local world time, each shot at the moment it was due within the frame
+	const double Now = GetWorld()->GetTimeSeconds();
+	TArray<double, TInlineAllocator<8>> ShotTimes;
+	for (double ShotAge : ShotAges)
+	{
+		ShotTimes.Add(Now - ShotAge);
+	}
 
-	// debug trace line: red: hit, green: no hit
-	if (GetWorld()->LineTraceSingleByChannel(OutHit, Start, End, ECollisionChannel::ECC_GameTraceChannel1, CollisionParams))
+	// damage to players is decided by the server against the hitboxes as this client saw them,
+	// on the server the validation trace is the only one and its result also drives the impacts
+	if (Character->HasAuthority())
 	{
-		if (OutHit.bBlockingHit)
+		for (double ShotTime : ShotTimes)
 		{
-			End = OutHit.Location;
-			DrawDebugLine(GetWorld(), Start, End, FColor::Red, false, 1.0f, 0, 0.5f);
+			ResolveShot(Start, ForwardVector, ShotTime);
+		}
+		return;
+	}
 
-			FString n1 = OutHit.GetActor()->GetName();
-			bool b1 = OutHit.Component->IsSimulatingPhysics();
+	// line trace: TC_Weapon trace channel check - ECC_GameTraceChannel1
+	// batched with every other shot of this frame, the results come back in OnShotsTraced next frame
+	if (UVRiCCTraceQueueSubsystem* TraceQueue = GetWorld()->GetSubsystem<UVRiCCTraceQueueSubsystem>())
+	{
+		TraceQueue->EnqueueShots(this, Character, Start, End, ShotTimes, false);
+	}
+	QueueServerShots(Start, ForwardVector, ShotAges);
+}
 
-			if ((OutHit.GetActor() != nullptr) && (OutHit.GetActor() != Character))
-			{
-				// add force to physical actors
-				if (OutHit.Component != nullptr && OutHit.Component->IsSimulatingPhysics())
-				{
-					FString s1 = OutHit.Component.Get()->GetName();
-					OutHit.Component->AddImpulseAtLocation(OutHit.ImpactNormal * -100000.0f, OutHit.ImpactPoint);
-				}
-
-				// add damage to enemy players
-				if (Cast<ACharacter>(OutHit.GetActor()))
-				{
-					TSubclassOf<UDamageType> DmgTypeClass = UDamageType::StaticClass();
-
-					OutHit.GetActor()->TakeDamage(0.1f, FDamageEvent(DmgTypeClass), GetOwner()->GetInstigatorController(), Character);
-				}
-			}
+// collected into one fire packet, sent when it is full or the flush interval ran out
+void UTP_WeaponComponent::QueueServerShots(const FVector& Start, const FVector& Direction, TConstArrayView<double> ShotAges)
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	const double ServerNow = GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : Now;
+
+	// one predicted ammo change per packet the batch lands in, so every sequence the server acks covers exactly the shots it spent
+	int32 NumChunkShots = 0;
+	for (int32 Index = 0; Index < ShotAges.Num(); ++Index)
+	{
+		if (PendingFirePacket.Num() == 0)
+		{
+			PendingFirePacketTime = Now;
 		}
-		else
+		PendingFirePacket.AddShot(Start, Direction, ServerNow - ShotAges[Index]);
+		NumChunkShots++;
+
+		if (PendingFirePacket.IsFull())
 		{
-			DrawDebugLine(GetWorld(), Start, End, FColor::Yellow, false, 1.0f, 0, 0.5f);
+			PendingFirePacket.SetSequence(PredictAmmoChange(NumChunkShots));
+			NumChunkShots = 0;
+			FlushFirePacket();
 		}
 	}
-	else
+	if (NumChunkShots > 0)
+	{
+		PendingFirePacket.SetSequence(PredictAmmoChange(NumChunkShots));
+	}
+
+	if (PendingFirePacket.Num() > 0 && Now - PendingFirePacketTime >= CVarFirePacketFlushInterval.GetValueOnGameThread())
 	{
-		DrawDebugLine(GetWorld(), Start, End, FColor::Green, false, 1.0f, 0, 0.5f);
+		FlushFirePacket();
 	}
+}
 
-	// Try and play the sound if specified
-	if (FireSound != nullptr)
+void UTP_WeaponComponent::FlushFirePacket()
+{
+	if (Character != nullptr && PendingFirePacket.Num() > 0)
 	{
-		UGameplayStatics::PlaySoundAtLocation(this, FireSound, Character->GetActorLocation());
+		Character->ServerFireShots(PendingFirePacket);
 	}
+	PendingFirePacket.Reset();
+}
 
-	// Try and play a firing animation if specified
-	if (FireAnimation != nullptr)
+// launch projectiles at the muzzle, simulated by the projectile manager or as pooled actors
+void UTP_WeaponComponent::FireProjectiles(TConstArrayView<double> ShotAges)
+{
+	const FRotator SpawnRotation = Character->GetControlRotation();
+	// MuzzleOffset is in camera space, so transform it to world space before offsetting from the character location to find the final muzzle position
+	const FVector SpawnLocation = Character->GetActorLocation() + SpawnRotation.RotateVector(MuzzleOffset);
+
+	UVRiCCProjectileManager* ProjectileManager = GetWorld()->GetSubsystem<UVRiCCProjectileManager>();
+	UVRiCCProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UVRiCCProjectilePoolSubsystem>();
+	for (int32 Index = 0; Index < ShotAges.Num(); ++Index)
 	{
-		// Get the animation object for the arms mesh
-		UAnimInstance* AnimInstance = Character->GetMesh1P()->GetAnimInstance();
-		if (AnimInstance != nullptr)
+		if (ProjectileManager != nullptr && UVRiCCProjectileManager::IsSimulationEnabled())
 		{
-			AnimInstance->Montage_Play(FireAnimation, 1.f);
+			ProjectileManager->SpawnProjectile(ProjectileClass, SpawnLocation, SpawnRotation.Vector(), Character);
 		}
+		else if (ProjectilePool != nullptr)
+		{
+			ProjectilePool->Acquire(ProjectileClass, FTransform(SpawnRotation, SpawnLocation), Character, Character);
+		}
+	}
+
+	// the server only spends the ammo of projectile shots, it has no hitscan to resolve for them
+	if (!Character->HasAuthority())
+	{
+		QueueServerShots(SpawnLocation, SpawnRotation.Vector(), ShotAges);
 	}
 }
 
+// server side hit resolution: world geometry is traced as it is now, characters as they were at ShotTime
+void UTP_WeaponComponent::ResolveShot(const FVector& Start, const FVector& Direction, double ShotTime)
+{
+	UVRiCCTraceQueueSubsystem* TraceQueue = GetWorld()->GetSubsystem<UVRiCCTraceQueueSubsystem>();
+	if (Character == nullptr || TraceQueue == nullptr)
+	{
+		return;
+	}
+
+	const FVector End = Start + Direction.GetSafeNormal() * GetStats().TraceLength;
+	TraceQueue->EnqueueShot(this, Character, Start, End, ShotTime, true);
+}
+
+// server side check of a client fire packet: the whole batch is refilled and charged against one token bucket,
+// shots that pass are resolved like any other server shot
+void UTP_WeaponComponent::ResolveShotPacket(const FVRiCCFirePacket& Packet)
+{
+	VRICC_SCOPE_CYCLE(ResolveShotPacket);
+
+	if (Character == nullptr || Packet.Num() == 0)
+	{
+		return;
+	}
+
+	FirePacketStats.Packets++;
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double ShotsPerSecond = FMath::Max(GetStats().RoundsPerMinute, CVarFirePacketMinRoundsPerMinute.GetValueOnGameThread()) / 60.0;
+	const double MaxTokens = 1.0 + ShotsPerSecond * CVarFirePacketBurstSeconds.GetValueOnGameThread();
+
+	// a weapon that was just picked up starts with a full bucket
+	FireTokens = FireTokens < 0.0 ? MaxTokens : FMath::Min(FireTokens + (Now - FireTokensTime) * ShotsPerSecond, MaxTokens);
+	FireTokensTime = Now;
+
+	const int32 NumAllowed = FMath::Min(Packet.Num(), FMath::FloorToInt(FireTokens));
+	FireTokens -= NumAllowed;
+	FirePacketStats.RateLimitedShots += Packet.Num() - NumAllowed;
+
+	const double MaxOriginErrorSquared = FMath::Square(CVarFirePacketMaxOriginError.GetValueOnGameThread());
+	const FVector CharacterLocation = Character->GetActorLocation();
+
+	for (int32 Index = 0; Index < NumAllowed; ++Index)
+	{
+		FVector Start;
+		FVector Direction;
+		double ShotTime;
+		Packet.GetShot(Index, Start, Direction, ShotTime);
+
+		if (!FMath::IsFinite(ShotTime) || FVector::DistSquared(Start, CharacterLocation) > MaxOriginErrorSquared)
+		{
+			FirePacketStats.RejectedShots++;
+			continue;
+		}
+
+		if (Character->VRiCC_ShotsLeft <= 0)
+		{
+			FirePacketStats.OutOfAmmoShots++;
+			continue;
+		}
+		Character->VRiCC_ShotsLeft--;
+
+		// the client's estimate of server time may step back a little, shots never rewind past one already accepted,
+		// and a time ahead of the server must not drag every later shot out of the rewind window with it
+		ShotTime = FMath::Clamp(ShotTime, Now - UVRiCCLagCompensationSubsystem::GetMaxRewind(), Now);
+		ShotTime = FMath::Max(ShotTime, LastAcceptedShotTime);
+		LastAcceptedShotTime = ShotTime;
+		FirePacketStats.AcceptedShots++;
+		if (!bFiresProjectiles)
+		{
+			ResolveShot(Start, Direction, ShotTime);
+		}
+	}
+
+	// the ack and the ammo it confirms go out in the same replication update
+	Character->CommitCombatState();
+	Character->AckAmmoChange(Packet.GetSequence());
+}
+
+void UTP_WeaponComponent::ResolveReload(uint16 Sequence)
+{
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	// the reload time is only enforced on the client, the server would start it half a round trip late
+	if (Character->VRiCC_ShotsLeft < Character->VRiCC_ShotsPerRack && Character->VRiCC_AmmoRacks > 0)
+	{
+		Character->VRiCC_ShotsLeft = Character->VRiCC_ShotsPerRack;
+		Character->VRiCC_AmmoRacks--;
+		Character->CommitCombatState();
+	}
+	Character->AckAmmoChange(Sequence);
+}
+
+uint16 UTP_WeaponComponent::PredictAmmoChange(int32 NumShots)
+{
+	if (PendingAmmoChanges.Num() >= VRiCCWeapon::MaxPendingAmmoChanges)
+	{
+		PendingAmmoChanges.RemoveAt(0);
+	}
+
+	FVRiCCPredictedAmmoChange& Change = PendingAmmoChanges.AddDefaulted_GetRef();
+	Change.Sequence = ++AmmoSequence;
+	Change.NumShots = NumShots;
+	return Change.Sequence;
+}
+
+// server state plus every change still in flight is what the client should be showing
+void UTP_WeaponComponent::ReconcileAmmo(int32 ServerShotsLeft, int32 ServerAmmoRacks, uint16 AckedSequence)
+{
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	PendingAmmoChanges.RemoveAll([AckedSequence](const FVRiCCPredictedAmmoChange& Change)
+	{
+		return !VRiCCWeapon::IsSequenceNewer(Change.Sequence, AckedSequence);
+	});
+
+	int32 ShotsLeft = ServerShotsLeft;
+	int32 AmmoRacks = ServerAmmoRacks;
+	for (const FVRiCCPredictedAmmoChange& Change : PendingAmmoChanges)
+	{
+		if (Change.NumShots > 0)
+		{
+			ShotsLeft = FMath::Max(ShotsLeft - Change.NumShots, 0);
+		}
+		else if (ShotsLeft < Character->VRiCC_ShotsPerRack && AmmoRacks > 0)
+		{
+			ShotsLeft = Character->VRiCC_ShotsPerRack;
+			AmmoRacks--;
+		}
+	}
+
+	// a correct prediction leaves the HUD alone, a wrong one rolls back to what the server decided
+	if (ShotsLeft != Character->VRiCC_ShotsLeft || AmmoRacks != Character->VRiCC_AmmoRacks)
+	{
+		AmmoMispredictions++;
+		Character->VRiCC_ShotsLeft = ShotsLeft;
+		Character->VRiCC_AmmoRacks = AmmoRacks;
+		Character->ShowAmmoInfo(_FiringMode);
+	}
+}
+
+void UTP_WeaponComponent::OnShotsTraced(TConstArrayView<FVRiCCShotTrace> Shots)
+{
+	VRICC_SCOPE_CYCLE(ShotsTraced);
+
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	const UVRiCCLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UVRiCCLagCompensationSubsystem>();
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	for (const FVRiCCShotTrace& Shot : Shots)
+	{
+		if (Shot.bServerValidation)
+		{
+			QueueServerHit(Shot, Shot.GetHit());
+			continue;
+		}
+
+		// the trace only saw world geometry, a character hitbox in front of it takes the shot
+		const FHitResult* WorldHit = Shot.GetHit();
+		const FVector WorldEnd = (WorldHit != nullptr && WorldHit->bBlockingHit) ? WorldHit->Location : Shot.End;
+		FVRiCCRewindHit CharacterHit;
+		if (LagCompensation != nullptr && LagCompensation->RewindTrace(Shot.Start, WorldEnd, Now, Character, CharacterHit))
+		{
+			VRICC_COUNT(Hits, 1);
+			ApplyShotImpact(Shot.Start, Shot.End, WorldHit, &CharacterHit);
+		}
+		else
+		{
+			ApplyShotImpact(Shot.Start, Shot.End, WorldHit, nullptr);
+		}
+	}
+}
+
+void UTP_WeaponComponent::ApplyShotImpact(const FVector& Start, const FVector& End, const FHitResult* WorldHit, const FVRiCCRewindHit* CharacterHit)
+{
+#if VRICC_WITH_PRESENTATION
+	UVRiCCImpactEffectsSubsystem* ImpactFX = GetWorld()->GetSubsystem<UVRiCCImpactEffectsSubsystem>();
+#endif
+#if VRICC_WITH_SHOT_DEBUG
+	UVRiCCShotDebugSubsystem* ShotDebug = GetWorld()->GetSubsystem<UVRiCCShotDebugSubsystem>();
+#endif
+
+	if (CharacterHit != nullptr)
+	{
+#if VRICC_WITH_SHOT_DEBUG
+		if (ShotDebug != nullptr)
+		{
+			ShotDebug->RecordShot(Start, CharacterHit->Location, CharacterHit->Character, EVRiCCShotDebugResult::CharacterHit);
+		}
+#endif
+#if VRICC_WITH_PRESENTATION
+		if (ImpactFX != nullptr)
+		{
+			ImpactFX->QueueImpact(ImpactEffects, CharacterHit->Location, CharacterHit->Normal, false);
+		}
+#endif
+		return;
+	}
+
+	if (WorldHit == nullptr || !WorldHit->bBlockingHit)
+	{
+#if VRICC_WITH_SHOT_DEBUG
+		if (ShotDebug != nullptr)
+		{
+			ShotDebug->RecordShot(Start, End, nullptr, EVRiCCShotDebugResult::Miss);
+		}
+#endif
+		return;
+	}
+
+	VRICC_COUNT(Hits, 1);
+
+	// add force to physical actors
+	AActor* HitActor = WorldHit->GetActor();
+	UPrimitiveComponent* HitComponent = WorldHit->GetComponent();
+	const bool bPhysicsHit = HitActor != nullptr && HitActor != Character && HitComponent != nullptr && HitComponent->IsSimulatingPhysics();
+	if (bPhysicsHit)
+	{
+		HitComponent->AddImpulseAtLocation(WorldHit->ImpactNormal * -GetStats().HitImpulse, WorldHit->ImpactPoint);
+	}
+
+#if VRICC_WITH_SHOT_DEBUG
+	if (ShotDebug != nullptr)
+	{
+		ShotDebug->RecordShot(Start, WorldHit->Location, HitActor, bPhysicsHit ? EVRiCCShotDebugResult::PhysicsHit : EVRiCCShotDebugResult::WorldHit);
+	}
+#endif
+#if VRICC_WITH_PRESENTATION
+	if (ImpactFX != nullptr)
+	{
+		ImpactFX->QueueImpact(ImpactEffects, WorldHit->ImpactPoint, WorldHit->ImpactNormal, HitComponent == nullptr || HitComponent->Mobility != EComponentMobility::Movable);
+	}
+#endif
+}
+
+void UTP_WeaponComponent::QueueServerHit(const FVRiCCShotTrace& Shot, const FHitResult* WorldHit)
+{
+	// world geometry in front of the target blocks the shot
+	const FVector End = (WorldHit != nullptr && WorldHit->bBlockingHit) ? WorldHit->Location : Shot.End;
+
+	// the hitboxes are checked by the shot resolver together with every other shot delivered this frame
+	if (UVRiCCShotResolverSubsystem* ShotResolver = GetWorld()->GetSubsystem<UVRiCCShotResolverSubsystem>())
+	{
+		// shots of a locally controlled shooter were only traced here, the resolver hands the result back for the impacts
+		ShotResolver->Enqueue(this, Character, Shot.Start, End, Shot.ShotTime, WorldHit, Character->IsLocallyControlled());
+	}
+}
+
+void UTP_WeaponComponent::ApplyServerHit(const FVRiCCRewindHit& RewindHit)
+{
+	if (Character == nullptr || RewindHit.Character == nullptr)
+	{
+		return;
+	}
+
+	// add damage to enemy players, applied with every other hit on them at the end of the frame
+	if (UVRiCCDamageSubsystem* DamageSubsystem = GetWorld()->GetSubsystem<UVRiCCDamageSubsystem>())
+	{
+		FVRiCCDamageRecord Record;
+		Record.Victim = RewindHit.Character;
+		Record.Instigator = Character->GetController();
+		Record.Causer = Character;
+		Record.Amount = GetStats().Damage;
+		Record.Type = EVRiCCDamageType::Shot;
+		Record.BodyPart = RewindHit.BodyPart;
+		DamageSubsystem->QueueDamage(Record);
+	}
+}
 
 // Fill the ammorack and decrease racks number
 void UTP_WeaponComponent::Reload()
@@ -165,18 +705,33 @@ void UTP_WeaponComponent::Reload()
 	{
 		_Reloading = true;
 
-		UGameplayStatics::PlaySoundAtLocation(this, ReloadSound, Character->GetActorLocation());
-		GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &UTP_WeaponComponent::ReloadAmmoReset, 1.0f, false);
+#if VRICC_WITH_PRESENTATION
+		if (UVRiCCWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UVRiCCWeaponAudioSubsystem>())
+		{
+			WeaponAudio->PlaySound(this, ReloadSound.Get(), Character->GetActorLocation());
+		}
+#endif
+		GetWorld()->GetTimerManager().SetTimer(ReloadTimerHandle, this, &UTP_WeaponComponent::ReloadAmmoReset, GetStats().ReloadSeconds, false);
 
 		Character->VRiCC_ShotsLeft = Character->VRiCC_ShotsPerRack;
 		Character->VRiCC_AmmoRacks--;
+		if (Character->HasAuthority())
+		{
+			Character->CommitCombatState();
+		}
+		else
+		{
+			// shots still waiting in the fire packet were fired from the old rack, the server has to see them first
+			FlushFirePacket();
+			Character->ServerReload(PredictAmmoChange(0));
+		}
 		Character->ShowAmmoInfo(_FiringMode);
 	}
 }
 
 // simple switch for firing mode
 // single = single shot
-// auto = firing continously per 0.5 seconds until needs to reload/holding fire
+// auto = firing continuously at the weapon's ShotInterval while fire is held, until it needs to reload
 void UTP_WeaponComponent::ChangeFireMode()
 {
 	if (_FiringMode == FiringMode::FiringMode_Single)
@@ -203,9 +758,71 @@ void UTP_WeaponComponent::AttachWeapon(AVRiCCCharacter* TargetCharacter)
 	
 	// switch bHasRifle so the animation blueprint can switch to another animation set
 	Character->SetHasRifle(true);
-	Character->AttachWeaponHUD(Character->GetMesh1P(), FName(TEXT("GripPoint")));
+	Character->SetWeapon(this);
+
+	// a weapon with its own definition comes with its own racks, the server hands them out
+	const FVRiCCWeaponStats& Stats = GetStats();
+	Character->VRiCC_ShotsPerRack = Stats.ShotsPerRack;
+	if (WeaponId != FVRiCCWeaponTable::DefaultWeaponId && Character->HasAuthority())
+	{
+		Character->VRiCC_ShotsLeft = Stats.ShotsPerRack;
+		Character->VRiCC_AmmoRacks = Stats.AmmoRacks;
+		Character->CommitCombatState();
+	}
+
+	// predicted ammo changes continue from the last one the server acknowledged for this character
+	AmmoSequence = Character->GetAmmoAckSequence();
+	PendingAmmoChanges.Reset();
+
+	// the server's racks may have replicated before this client attached the weapon, nothing reconciled them then
+	if (!Character->HasAuthority() && Character->IsLocallyControlled())
+	{
+		Character->ReconcileAmmo();
+	}
+#if VRICC_WITH_PRESENTATION
+	if (VRiCC::IsPresentationEnabled(this))
+	{
+		Character->AttachWeaponHUD(Character->GetMesh1P(), FName(TEXT("GripPoint")));
+		Character->GetHUDModel()->MarkAllDirty();
+	}
+
+	if (UVRiCCWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UVRiCCWeaponAudioSubsystem>())
+	{
+		WeaponAudio->RegisterWeapon(this);
+	}
+
+	// sounds and animation stream in now, shots fired before they arrive are silent; servers never load them
+	if (VRiCC::IsPresentationEnabled(this) && !CosmeticsHandle.IsValid())
+	{
+		TArray<FSoftObjectPath> CosmeticPaths;
+		for (const TSoftObjectPtr<USoundBase>* Sound : { &FireSound, &ReloadSound, &EmptySound, &FireLoopSound, &FireTailSound })
+		{
+			if (!Sound->IsNull())
+			{
+				CosmeticPaths.Add(Sound->ToSoftObjectPath());
+			}
+		}
+		if (!FireAnimation.IsNull())
+		{
+			CosmeticPaths.Add(FireAnimation.ToSoftObjectPath());
+		}
+		if (CosmeticPaths.Num() > 0)
+		{
+			CosmeticsHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(CosmeticPaths, FStreamableDelegate(), FStreamableManager::AsyncLoadHighPriority);
+		}
+	}
+#endif
 	Character->ShowAmmoInfo(_FiringMode);
 
+	// have the projectiles ready before the first shot instead of spawning them while firing
+	if (bFiresProjectiles && ProjectileClass != nullptr)
+	{
+		if (UVRiCCProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UVRiCCProjectilePoolSubsystem>())
+		{
+			ProjectilePool->Prewarm(ProjectileClass, ProjectilePoolSize);
+		}
+	}
+
 	// Set up action bindings
 	if (APlayerController* PlayerController = Cast<APlayerController>(Character->GetController()))
 	{
@@ -231,6 +848,14 @@ void UTP_WeaponComponent::AttachWeapon(AVRiCCCharacter* TargetCharacter)
 
 void UTP_WeaponComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
+#if VRICC_WITH_PRESENTATION
+	if (UVRiCCWeaponAudioSubsystem* WeaponAudio = GetWorld()->GetSubsystem<UVRiCCWeaponAudioSubsystem>())
+	{
+		WeaponAudio->UnregisterWeapon(this);
+	}
+	CosmeticsHandle.Reset();
+#endif
+
 	if (Character == nullptr)
 	{
 		return;
@@ -5,10 +5,37 @@
 #include "CoreMinimal.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "VRiCCCharacter.h"
+#include "VRiCCFirePacket.h"
+#include "VRiCCImpactEffects.h"
+#include "VRiCCWeaponDefinition.h"
 #include "TP_WeaponComponent.generated.h"
 
 class AVRiCCCharacter;
+struct FVRiCCShotTrace;
+struct FVRiCCRewindHit;
+struct FStreamableHandle;
 
+/** Server side counters of the fire packets received by one weapon, for VRiCC.FirePacket.Stats */
+struct FVRiCCFirePacketStats
+{
+	uint64 Packets = 0;
+	uint64 AcceptedShots = 0;
+	/** Shots beyond what the fire rate allows */
+	uint64 RateLimitedShots = 0;
+	/** Shots whose origin was too far from the character */
+	uint64 RejectedShots = 0;
+	/** Shots the server had no ammo for */
+	uint64 OutOfAmmoShots = 0;
+};
+
+/** Ammo change the owning client applied before the server confirmed it */
+struct FVRiCCPredictedAmmoChange
+{
+	uint16 Sequence = 0;
+
+	/** Shots fired, 0 for a reload */
+	int32 NumShots = 0;
+};
 
 
 UCLASS(Blueprintable, BlueprintType, ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
@@ -21,19 +48,43 @@ public:
 	UPROPERTY(EditDefaultsOnly, Category=Projectile)
 	TSubclassOf<class AVRiCCProjectile> ProjectileClass;
 
-	/** Sound to play each time we fire */
+	/** Fire ProjectileClass instead of a hitscan trace */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile)
+	bool bFiresProjectiles;
+
+	/** Projectiles created up front when the weapon is picked up */
+	UPROPERTY(EditDefaultsOnly, Category=Projectile, meta=(ClampMin = "0", EditCondition = "bFiresProjectiles"))
+	int32 ProjectilePoolSize;
+
+	/** Tuning and cosmetics of this weapon, without one it fires as the built-in rifle with the sounds set below */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category=Weapon)
+	TObjectPtr<UVRiCCWeaponDefinition> Definition;
+
+	/** Sound to play each time we fire, sounds and animations stream in when the weapon is picked up */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
-	USoundBase* FireSound;
+	TSoftObjectPtr<USoundBase> FireSound;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
+	TSoftObjectPtr<USoundBase> ReloadSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	USoundBase* ReloadSound;
+	TSoftObjectPtr<USoundBase> EmptySound;
 
+	/** Looping sound played while automatic fire is held, instead of FireSound per shot */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	USoundBase* EmptySound;
+	TSoftObjectPtr<USoundBase> FireLoopSound;
+
+	/** Played when the automatic fire loop stops */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
+	TSoftObjectPtr<USoundBase> FireTailSound;
+
+	/** Particles and decal left where a hitscan shot lands */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
+	FVRiCCImpactEffectSet ImpactEffects;
 
 	/** AnimMontage to play each time we fire */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Gameplay)
-	UAnimMontage* FireAnimation;
+	TSoftObjectPtr<UAnimMontage> FireAnimation;
 
 	/** Gun muzzle's offset from the characters location */
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category=Gameplay)
@@ -54,6 +105,10 @@ public:
 	/** Sets default values for this component's properties */
 	UTP_WeaponComponent();
 
+	virtual void BeginPlay() override;
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
 	/** Attaches the actor to a FirstPersonCharacter */
 	UFUNCTION(BlueprintCallable, Category="Weapon")
 	void AttachWeapon(AVRiCCCharacter* TargetCharacter);
@@ -70,6 +125,43 @@ public:
 	void Reload();
 	void FireAndHit();
 
+	/** Fires one shot per entry as one batch, ShotAges are the seconds since each shot was due */
+	void FireShots(TConstArrayView<double> ShotAges);
+
+	FiringMode GetFiringMode() const { return _FiringMode; }
+
+	/** Compiled tuning of Definition, read by index so firing never touches the data asset */
+	const FVRiCCWeaponStats& GetStats() const { return FVRiCCWeaponTable::Get(WeaponId); }
+
+	/** Server only: queues the hit of a shot fired at ShotTime for validation against lag compensated hitboxes */
+	void ResolveShot(const FVector& Start, const FVector& Direction, double ShotTime);
+
+	/** Server only: validates and rate limits the shots of a client packet as a batch, then resolves the ones that pass */
+	void ResolveShotPacket(const FVRiCCFirePacket& Packet);
+
+	const FVRiCCFirePacketStats& GetFirePacketStats() const { return FirePacketStats; }
+
+	/** Server only: reloads for a client that already predicted the reload, then acknowledges Sequence */
+	void ResolveReload(uint16 Sequence);
+
+	/** Owning client only: rebuilds the predicted ammo from the server state and the changes it has not acknowledged yet */
+	void ReconcileAmmo(int32 ServerShotsLeft, int32 ServerAmmoRacks, uint16 AckedSequence);
+
+	/** Reconciles that had to correct the predicted ammo */
+	uint64 GetAmmoMispredictions() const { return AmmoMispredictions; }
+
+	/** Shots this weapon fired since it was created, input replays compare it with the recording */
+	uint32 GetShotsFired() const { return ShotsFired; }
+
+	/** Called by the trace queue the frame after shots were queued, once for all consecutive shots of this weapon */
+	void OnShotsTraced(TConstArrayView<FVRiCCShotTrace> Shots);
+
+	/** Impulse, impact effects and debug record of a shot, CharacterHit takes precedence over WorldHit */
+	void ApplyShotImpact(const FVector& Start, const FVector& End, const FHitResult* WorldHit, const FVRiCCRewindHit* CharacterHit);
+
+	/** Server only: applies the damage of a shot the shot resolver validated against the rewound hitboxes */
+	void ApplyServerHit(const FVRiCCRewindHit& RewindHit);
+
 protected:
 	/** Ends gameplay for this component. */
 	UFUNCTION()
@@ -78,12 +170,64 @@ protected:
 	UFUNCTION()
 	void ReloadAmmoReset() { _Reloading = false; }
 
+	/** Hitscan shots, traced asynchronously and validated by the server */
+	void FireTrace(TConstArrayView<double> ShotAges);
+
+	/** Client only: sends the shots collected in PendingFirePacket to the server */
+	void FlushFirePacket();
+
+	/** Client only: adds shots to PendingFirePacket, fired from Start along Direction, predicting one ammo change per packet they land in */
+	void QueueServerShots(const FVector& Start, const FVector& Direction, TConstArrayView<double> ShotAges);
+
+	/** Client only: remembers an ammo change applied ahead of the server and returns its sequence number */
+	uint16 PredictAmmoChange(int32 NumShots);
+
+	/** Launches one projectile per shot, taken from the projectile pool */
+	void FireProjectiles(TConstArrayView<double> ShotAges);
+
+	/** Hands a server validation shot to the shot resolver, WorldHit is the closest world geometry along the shot */
+	void QueueServerHit(const FVRiCCShotTrace& Shot, const FHitResult* WorldHit);
+
 private:
 	/** The Character holding this weapon*/
 	AVRiCCCharacter* Character;
 
 	FTimerHandle ReloadTimerHandle;
-	FTimerHandle AutoFireTimerHandle;
+
+	/** Trigger held in automatic mode, the tick fires every shot that became due */
+	bool bAutoFireHeld;
+
+	/** Seconds since the last automatic shot was due */
+	double AutoFireAccumulator;
+
+	/** Ages of the automatic shots due this frame, kept to reuse the allocation */
+	TArray<double> DueShotAges;
+
+	/** Client only: shots not sent to the server yet and the time the first of them was added */
+	FVRiCCFirePacket PendingFirePacket;
+	double PendingFirePacketTime;
+
+	/** Server only: token bucket of shots the client may still fire, refilled at the fire rate */
+	double FireTokens;
+	double FireTokensTime;
+
+	/** Server only: time of the last accepted shot, later shots are never rewound further back */
+	double LastAcceptedShotTime;
+
+	FVRiCCFirePacketStats FirePacketStats;
+
+	/** Owning client only: last sequence number handed out and the changes the server has not acknowledged */
+	uint16 AmmoSequence;
+	TArray<FVRiCCPredictedAmmoChange> PendingAmmoChanges;
+	uint64 AmmoMispredictions;
+
+	uint32 ShotsFired;
+
+	/** Row of Definition in FVRiCCWeaponTable, resolved in BeginPlay */
+	uint16 WeaponId;
+
+	/** Keeps the sounds and animation streamed in by AttachWeapon loaded while the weapon is held */
+	TSharedPtr<FStreamableHandle> CosmeticsHandle;
 
 	bool	_Reloading;
 	FiringMode _FiringMode;
@@ -1,7 +1,17 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "VRiCC.h"
+#include "Engine/World.h"
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, VRiCC, "VRiCC" );
- 
\ No newline at end of file
+
+bool VRiCC::IsPresentationEnabled(const UObject* WorldContextObject)
+{
+#if VRICC_WITH_PRESENTATION
+	const UWorld* World = WorldContextObject != nullptr ? WorldContextObject->GetWorld() : nullptr;
+	return World != nullptr && World->GetNetMode() != NM_DedicatedServer;
+#else
+	return false;
+#endif
+}
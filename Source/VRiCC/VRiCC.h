@@ -3,3 +3,15 @@
 #pragma once
 
 #include "CoreMinimal.h"
+
+/** Sounds, animation montages, debug draws and HUD events, compiled out of the VRiCCServer target */
+#define VRICC_WITH_PRESENTATION (!UE_SERVER)
+
+/** Shot recording, drawing and export of the shot debug ring, compiled out of shipping builds */
+#define VRICC_WITH_SHOT_DEBUG (!UE_BUILD_SHIPPING)
+
+namespace VRiCC
+{
+	/** False when nobody can see or hear the world of WorldContextObject: dedicated servers, including -server runs of the game and editor targets */
+	VRICC_API bool IsPresentationEnabled(const UObject* WorldContextObject);
+}
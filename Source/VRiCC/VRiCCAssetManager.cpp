@@ -0,0 +1,175 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCAssetManager.h"
+#include "VRiCCWeaponDefinition.h"
+#include "Dom/JsonObject.h"
+#include "Engine/Engine.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/CoreDelegates.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "UObject/UObjectGlobals.h"
+
+const FName VRiCCAssetBundles::Gameplay(TEXT("Gameplay"));
+const FName VRiCCAssetBundles::Cosmetic(TEXT("Cosmetic"));
+
+const FPrimaryAssetId UVRiCCAssetManager::StartupAssetId(TEXT("VRiCCStartup"), TEXT("Default"));
+
+UVRiCCAssetManager* UVRiCCAssetManager::Get()
+{
+	return GEngine != nullptr ? Cast<UVRiCCAssetManager>(GEngine->AssetManager) : nullptr;
+}
+
+TArray<FName> UVRiCCAssetManager::GetLoadedBundles()
+{
+	TArray<FName> Bundles = { VRiCCAssetBundles::Gameplay };
+	if (!IsRunningDedicatedServer())
+	{
+		Bundles.Add(VRiCCAssetBundles::Cosmetic);
+	}
+	return Bundles;
+}
+
+void UVRiCCAssetManager::StartInitialLoading()
+{
+	Super::StartInitialLoading();
+
+	MarkStartupMilestone(TEXT("AssetManager"));
+	FCoreDelegates::OnFEngineLoopInitComplete.AddWeakLambda(this, [this]()
+	{
+		MarkStartupMilestone(TEXT("EngineInit"));
+	});
+	FCoreUObjectDelegates::PostLoadMapWithWorld.AddWeakLambda(this, [this](UWorld* World)
+	{
+		MarkStartupMilestone(TEXT("MapLoaded"));
+	});
+
+	// one primary asset holds both bundles, so servers and clients share a list and only differ in what they request
+	FAssetBundleData BundleData;
+	for (const FSoftObjectPath& Path : StartupGameplayAssets)
+	{
+		BundleData.AddBundleAsset(VRiCCAssetBundles::Gameplay, Path.GetAssetPath());
+	}
+	for (const FSoftObjectPath& Path : StartupCosmeticAssets)
+	{
+		BundleData.AddBundleAsset(VRiCCAssetBundles::Cosmetic, Path.GetAssetPath());
+	}
+	AddDynamicAsset(StartupAssetId, FSoftObjectPath(), BundleData);
+
+	StartupHandle = LoadPrimaryAsset(StartupAssetId, GetLoadedBundles(),
+		FStreamableDelegate::CreateUObject(this, &UVRiCCAssetManager::OnStartupPreloadComplete), FStreamableManager::AsyncLoadHighPriority);
+	if (!StartupHandle.IsValid())
+	{
+		// nothing left to stream, everything is in memory already
+		OnStartupPreloadComplete();
+	}
+
+	// weapon tuning is small and wanted everywhere, the Cosmetic bundle waits for the first pickup
+	TArray<FPrimaryAssetId> WeaponIds;
+	GetPrimaryAssetIdList(UVRiCCWeaponDefinition::PrimaryAssetType, WeaponIds);
+	if (WeaponIds.Num() > 0)
+	{
+		WeaponHandle = LoadPrimaryAssets(WeaponIds, { VRiCCAssetBundles::Gameplay },
+			FStreamableDelegate::CreateUObject(this, &UVRiCCAssetManager::OnWeaponDefinitionsLoaded), FStreamableManager::AsyncLoadHighPriority);
+		if (!WeaponHandle.IsValid())
+		{
+			OnWeaponDefinitionsLoaded();
+		}
+	}
+}
+
+void UVRiCCAssetManager::OnWeaponDefinitionsLoaded()
+{
+	TArray<UObject*> Definitions;
+	GetPrimaryAssetObjectList(UVRiCCWeaponDefinition::PrimaryAssetType, Definitions);
+	for (const UObject* Definition : Definitions)
+	{
+		FVRiCCWeaponTable::FindOrAdd(Cast<UVRiCCWeaponDefinition>(Definition));
+	}
+	UE_LOG(LogTemp, Display, TEXT("Startup: %d weapon definitions compiled"), FVRiCCWeaponTable::Num() - 1);
+}
+
+bool UVRiCCAssetManager::IsStartupPreloadComplete() const
+{
+	return !StartupHandle.IsValid() || StartupHandle->HasLoadCompleted();
+}
+
+void UVRiCCAssetManager::OnStartupPreloadComplete()
+{
+	MarkStartupMilestone(TEXT("Preload"));
+}
+
+void UVRiCCAssetManager::MarkStartupMilestone(const TCHAR* Name)
+{
+	if (bPlayable || Milestones.ContainsByPredicate([Name](const TPair<FString, double>& Milestone) { return Milestone.Key == Name; }))
+	{
+		return;
+	}
+
+	const double Seconds = FPlatformTime::Seconds() - GStartTime;
+	Milestones.Emplace(Name, Seconds);
+	UE_LOG(LogTemp, Display, TEXT("Startup: %s after %.3fs"), Name, Seconds);
+}
+
+void UVRiCCAssetManager::MarkPlayable()
+{
+	if (bPlayable)
+	{
+		return;
+	}
+	MarkStartupMilestone(TEXT("Playable"));
+	bPlayable = true;
+
+	const double PlayableSeconds = Milestones.Last().Value;
+	FString Steps;
+	double PreviousSeconds = 0.0;
+	for (const TPair<FString, double>& Milestone : Milestones)
+	{
+		Steps += FString::Printf(TEXT(" %s +%.3fs"), *Milestone.Key, Milestone.Value - PreviousSeconds);
+		PreviousSeconds = Milestone.Value;
+	}
+	UE_LOG(LogTemp, Display, TEXT("Startup: %s playable after %.3fs:%s"), IsRunningDedicatedServer() ? TEXT("server") : TEXT("client"), PlayableSeconds, *Steps);
+
+	// tracked across builds by writing the milestones next to the perf suite results
+	FString Path;
+	if (FParse::Value(FCommandLine::Get(), TEXT("VRiCCStartupReport="), Path) || FParse::Param(FCommandLine::Get(), TEXT("VRiCCStartupReport")))
+	{
+		if (Path.IsEmpty())
+		{
+			Path = FPaths::ProjectSavedDir() / TEXT("Perf") / FString::Printf(TEXT("Startup-%s.json"), *FDateTime::Now().ToString());
+		}
+		WriteStartupReport(Path);
+	}
+}
+
+void UVRiCCAssetManager::WriteStartupReport(const FString& Path) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("Version"), 1);
+	Root->SetStringField(TEXT("Role"), IsRunningDedicatedServer() ? TEXT("Server") : TEXT("Client"));
+	Root->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+	Root->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+
+	TSharedRef<FJsonObject> Seconds = MakeShared<FJsonObject>();
+	for (const TPair<FString, double>& Milestone : Milestones)
+	{
+		Seconds->SetNumberField(Milestone.Key, Milestone.Value);
+	}
+	Root->SetObjectField(TEXT("Milestones"), Seconds);
+
+	FString Json;
+	FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Json));
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Display, TEXT("Startup: report written to %s"), *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Startup: could not write %s"), *Path);
+	}
+}
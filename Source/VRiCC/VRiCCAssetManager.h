@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetManager.h"
+#include "VRiCCAssetManager.generated.h"
+
+struct FStreamableHandle;
+
+/** Asset bundles of VRiCC primary assets */
+namespace VRiCCAssetBundles
+{
+	/** Everything the simulation needs, the only bundle a dedicated server loads */
+	extern VRICC_API const FName Gameplay;
+	/** Sounds, animations and effects, only loaded where the game is presented */
+	extern VRICC_API const FName Cosmetic;
+}
+
+/**
+ * Streams the startup assets while the engine and the map load, instead of every hard reference blocking
+ * the game thread in turn. The assets listed in DefaultGame.ini are registered as the dynamic primary asset
+ * VRiCCStartup:Default with a Gameplay and a Cosmetic bundle, and loaded asynchronously with the bundles
+ * this process needs. Also times startup from process launch to the first playable frame, logged as
+ * "Startup:" and written to Saved/Perf/ with -VRiCCStartupReport[=Path]. Weapon definitions are loaded
+ * without their Cosmetic bundle and compiled into FVRiCCWeaponTable.
+ * Set as AssetManagerClassName in DefaultEngine.ini.
+ */
+UCLASS(Config = Game)
+class VRICC_API UVRiCCAssetManager : public UAssetManager
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetId StartupAssetId;
+
+	/** Null when another asset manager class is configured */
+	static UVRiCCAssetManager* Get();
+
+	// UAssetManager interface
+	virtual void StartInitialLoading() override;
+	// End of UAssetManager interface
+
+	/** Bundles this process loads: Gameplay everywhere, Cosmetic everywhere but dedicated servers */
+	static TArray<FName> GetLoadedBundles();
+
+	bool IsStartupPreloadComplete() const;
+
+	/** Records a startup step with the seconds since process launch, the first call per Name counts */
+	void MarkStartupMilestone(const TCHAR* Name);
+
+	/** Ends startup timing at the first playable frame and reports it, later calls do nothing */
+	void MarkPlayable();
+
+	/** Classes and assets the game needs before the first player spawns */
+	UPROPERTY(Config)
+	TArray<FSoftObjectPath> StartupGameplayAssets;
+
+	/** Presentation assets worth having before the first shot, skipped by dedicated servers */
+	UPROPERTY(Config)
+	TArray<FSoftObjectPath> StartupCosmeticAssets;
+
+private:
+	void OnStartupPreloadComplete();
+	void WriteStartupReport(const FString& Path) const;
+
+	/** Compiles the loaded VRiCCWeapon definitions into FVRiCCWeaponTable */
+	void OnWeaponDefinitionsLoaded();
+
+	TSharedPtr<FStreamableHandle> StartupHandle;
+
+	/** Keeps the Gameplay bundle of every weapon definition loaded */
+	TSharedPtr<FStreamableHandle> WeaponHandle;
+
+	/** Milestone names and seconds since process launch, in the order they happened */
+	TArray<TPair<FString, double>> Milestones;
+
+	bool bPlayable = false;
+};
@@ -0,0 +1,237 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCBotComponent.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCSpawnerRegistry.h"
+#include "TP_WeaponComponent.h"
+#include "WeaponSpawner.h"
+#include "GameFramework/Controller.h"
+#include "InputActionValue.h"
+#include "Misc/CommandLine.h"
+
+UVRiCCBotComponent::UVRiCCBotComponent()
+{
+	PrimaryComponentTick.bCanEverTick = true;
+
+	Behavior = EVRiCCBotBehavior::Random;
+	Seed = 0;
+	SingleFireInterval = 0.25f;
+
+	MoveValue = FVector2D::ZeroVector;
+	LookRate = FVector2D::ZeroVector;
+	ActionEndTime = 0.0;
+	ScriptStep = INDEX_NONE;
+	bHoldingTrigger = false;
+	NextTriggerTime = 0.0;
+}
+
+void UVRiCCBotComponent::ConfigureFromCommandLine()
+{
+	FString BehaviorName;
+	if (FParse::Value(FCommandLine::Get(), TEXT("VRiCCBotBehavior="), BehaviorName))
+	{
+		Behavior = BehaviorName.Equals(TEXT("Scripted"), ESearchCase::IgnoreCase) ? EVRiCCBotBehavior::Scripted : EVRiCCBotBehavior::Random;
+	}
+	FParse::Value(FCommandLine::Get(), TEXT("VRiCCBotSeed="), Seed);
+}
+
+void UVRiCCBotComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	Random.Initialize(Seed);
+
+	if (Script.Num() == 0)
+	{
+		auto AddStep = [this](EVRiCCBotActionType Type, FVector2D Value, float Duration)
+		{
+			FVRiCCBotAction& Action = Script.AddDefaulted_GetRef();
+			Action.Type = Type;
+			Action.Value = Value;
+			Action.Duration = Duration;
+		};
+
+		// patrol, turn, shoot in both fire modes and reload
+		AddStep(EVRiCCBotActionType::Move, FVector2D(0.f, 1.f), 2.f);
+		AddStep(EVRiCCBotActionType::Look, FVector2D(90.f, 0.f), 1.f);
+		AddStep(EVRiCCBotActionType::Fire, FVector2D::ZeroVector, 1.5f);
+		AddStep(EVRiCCBotActionType::Move, FVector2D(1.f, 0.f), 1.f);
+		AddStep(EVRiCCBotActionType::ChangeFireMode, FVector2D::ZeroVector, 0.f);
+		AddStep(EVRiCCBotActionType::Fire, FVector2D::ZeroVector, 2.f);
+		AddStep(EVRiCCBotActionType::Reload, FVector2D::ZeroVector, 1.f);
+		AddStep(EVRiCCBotActionType::Wait, FVector2D::ZeroVector, 0.5f);
+	}
+}
+
+void UVRiCCBotComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (AVRiCCCharacter* Character = GetCharacter())
+	{
+		ReleaseTrigger(Character->GetWeapon());
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AVRiCCCharacter* UVRiCCBotComponent::GetCharacter() const
+{
+	const AController* Controller = Cast<AController>(GetOwner());
+	return Controller != nullptr ? Cast<AVRiCCCharacter>(Controller->GetPawn()) : nullptr;
+}
+
+void UVRiCCBotComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	AVRiCCCharacter* Character = GetCharacter();
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	if (!Character->GetHasRifle())
+	{
+		SeekWeapon(Character);
+		return;
+	}
+
+	if (GetWorld()->GetTimeSeconds() >= ActionEndTime)
+	{
+		if (Behavior == EVRiCCBotBehavior::Scripted)
+		{
+			ThinkScripted(Character);
+		}
+		else
+		{
+			ThinkRandom(Character);
+		}
+	}
+
+	// the same calls the input bindings make every frame the sticks or mouse are held
+	if (!MoveValue.IsZero())
+	{
+		Character->Move(FInputActionValue(MoveValue));
+	}
+	if (!LookRate.IsZero())
+	{
+		Character->Look(FInputActionValue(LookRate * DeltaTime));
+	}
+
+	// single fire needs a press per shot, held auto fire is scheduled by the weapon's AutoFireAccumulator in its tick
+	UTP_WeaponComponent* Weapon = Character->GetWeapon();
+	if (bHoldingTrigger && Weapon != nullptr && Weapon->GetFiringMode() == FiringMode::FiringMode_Single && GetWorld()->GetTimeSeconds() >= NextTriggerTime)
+	{
+		ReleaseTrigger(Weapon);
+		PressTrigger(Weapon);
+	}
+}
+
+void UVRiCCBotComponent::SeekWeapon(AVRiCCCharacter* Character)
+{
+	const UVRiCCSpawnerRegistry* SpawnerRegistry = GetWorld()->GetSubsystem<UVRiCCSpawnerRegistry>();
+	const AWeaponSpawner* Spawner = SpawnerRegistry != nullptr ? SpawnerRegistry->Resolve(SpawnerRegistry->FindNearest(Character->GetActorLocation())) : nullptr;
+	if (Spawner == nullptr)
+	{
+		return;
+	}
+
+	// turn towards the spawner while walking forward, the yaw error shrinks as the look input is applied
+	const FVector ToSpawner = Spawner->GetActorLocation() - Character->GetActorLocation();
+	const float YawError = FRotator::NormalizeAxis(ToSpawner.Rotation().Yaw - Character->GetControlRotation().Yaw);
+	Character->Look(FInputActionValue(FVector2D(FMath::Clamp(YawError * 0.1f, -5.f, 5.f), 0.f)));
+	Character->Move(FInputActionValue(FVector2D(0.f, 1.f)));
+}
+
+void UVRiCCBotComponent::ThinkRandom(AVRiCCCharacter* Character)
+{
+	UTP_WeaponComponent* Weapon = Character->GetWeapon();
+	ReleaseTrigger(Weapon);
+
+	// standing still now and then keeps the movement mix close to real players
+	MoveValue = Random.FRand() < 0.3f ? FVector2D::ZeroVector : FVector2D(Random.FRandRange(-1.f, 1.f), Random.FRandRange(-1.f, 1.f));
+	LookRate = FVector2D(Random.FRandRange(-90.f, 90.f), Random.FRandRange(-10.f, 10.f));
+
+	const float Roll = Random.FRand();
+	if (Roll < 0.05f && Weapon != nullptr)
+	{
+		Weapon->ChangeFireMode();
+	}
+	else if (Roll < 0.1f && Weapon != nullptr)
+	{
+		Weapon->Reload();
+	}
+	else if (Roll < 0.6f)
+	{
+		PressTrigger(Weapon);
+	}
+
+	ActionEndTime = GetWorld()->GetTimeSeconds() + Random.FRandRange(0.5f, 2.5f);
+}
+
+void UVRiCCBotComponent::ThinkScripted(AVRiCCCharacter* Character)
+{
+	UTP_WeaponComponent* Weapon = Character->GetWeapon();
+	ReleaseTrigger(Weapon);
+	MoveValue = FVector2D::ZeroVector;
+	LookRate = FVector2D::ZeroVector;
+
+	ScriptStep = (ScriptStep + 1) % Script.Num();
+	const FVRiCCBotAction& Action = Script[ScriptStep];
+
+	switch (Action.Type)
+	{
+	case EVRiCCBotActionType::Move:
+		MoveValue = Action.Value;
+		break;
+
+	case EVRiCCBotActionType::Look:
+		LookRate = Action.Value;
+		break;
+
+	case EVRiCCBotActionType::Fire:
+		PressTrigger(Weapon);
+		break;
+
+	case EVRiCCBotActionType::Reload:
+		if (Weapon != nullptr)
+		{
+			Weapon->Reload();
+		}
+		break;
+
+	case EVRiCCBotActionType::ChangeFireMode:
+		if (Weapon != nullptr)
+		{
+			Weapon->ChangeFireMode();
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	ActionEndTime = GetWorld()->GetTimeSeconds() + Action.Duration;
+}
+
+void UVRiCCBotComponent::PressTrigger(UTP_WeaponComponent* Weapon)
+{
+	if (Weapon == nullptr)
+	{
+		return;
+	}
+
+	// Started then Triggered, in the order the fire action delivers them
+	Weapon->AutoFire();
+	Weapon->Fire();
+	bHoldingTrigger = true;
+	NextTriggerTime = GetWorld()->GetTimeSeconds() + SingleFireInterval;
+}
+
+void UVRiCCBotComponent::ReleaseTrigger(UTP_WeaponComponent* Weapon)
+{
+	if (bHoldingTrigger && Weapon != nullptr)
+	{
+		Weapon->FireStop();
+	}
+	bHoldingTrigger = false;
+}
@@ -0,0 +1,111 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Math/RandomStream.h"
+#include "VRiCCBotComponent.generated.h"
+
+class AVRiCCCharacter;
+class UTP_WeaponComponent;
+
+UENUM(BlueprintType)
+enum class EVRiCCBotBehavior : uint8
+{
+	/** Random moves, looks and trigger pulls from a seeded stream */
+	Random,
+	/** Loops through Script */
+	Scripted
+};
+
+UENUM(BlueprintType)
+enum class EVRiCCBotActionType : uint8
+{
+	Wait,
+	Move,
+	Look,
+	Fire,
+	Reload,
+	ChangeFireMode
+};
+
+/** One step of a scripted bot, Move and Look apply Value for Duration seconds, Fire holds the trigger that long */
+USTRUCT(BlueprintType)
+struct FVRiCCBotAction
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	EVRiCCBotActionType Type = EVRiCCBotActionType::Wait;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	FVector2D Value = FVector2D::ZeroVector;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot", meta = (ClampMin = "0"))
+	float Duration = 0.f;
+};
+
+/**
+ * Plays a local player controller like a human would, for load testing.
+ * Drives the possessed AVRiCCCharacter through the same Move, Look, Fire, Reload and ChangeFireMode
+ * calls the input bindings use, so a client running it produces real player traffic on the server.
+ * Added to the local player controller when the client is started with -VRiCCBot.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class VRICC_API UVRiCCBotComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UVRiCCBotComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Reads -VRiCCBotBehavior=Random|Scripted and -VRiCCBotSeed=N */
+	void ConfigureFromCommandLine();
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	EVRiCCBotBehavior Behavior;
+
+	/** Seed of the random behavior, the launcher gives every bot its own */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	int32 Seed;
+
+	/** Steps of the scripted behavior, a default patrol and shoot loop is used when empty */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot")
+	TArray<FVRiCCBotAction> Script;
+
+	/** Seconds between trigger presses while holding fire in single fire mode */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Bot", meta = (ClampMin = "0.01"))
+	float SingleFireInterval;
+
+protected:
+	virtual void BeginPlay() override;
+
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	AVRiCCCharacter* GetCharacter() const;
+
+	/** Walks towards the closest weapon spawner until the character carries a rifle */
+	void SeekWeapon(AVRiCCCharacter* Character);
+
+	void ThinkRandom(AVRiCCCharacter* Character);
+	void ThinkScripted(AVRiCCCharacter* Character);
+
+	void PressTrigger(UTP_WeaponComponent* Weapon);
+	void ReleaseTrigger(UTP_WeaponComponent* Weapon);
+
+	FRandomStream Random;
+
+	FVector2D MoveValue;
+	FVector2D LookRate;
+
+	/** World time the current random decision or script step ends */
+	double ActionEndTime;
+	int32 ScriptStep;
+
+	bool bHoldingTrigger;
+	double NextTriggerTime;
+};
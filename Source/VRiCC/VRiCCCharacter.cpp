@@ -1,7 +1,13 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "VRiCCCharacter.h"
+#include "VRiCC.h"
+#include "VRiCCDamage.h"
+#include "VRiCCHUDModel.h"
 #include "VRiCCProjectile.h"
+#include "VRiCCStats.h"
+#include "VRiCCWeaponDefinition.h"
+#include "TP_WeaponComponent.h"
 #include "Animation/AnimInstance.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
@@ -11,6 +17,7 @@
 #include "InputActionValue.h"
 #include "Engine/LocalPlayer.h"
 #include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 DEFINE_LOG_CATEGORY(LogTemplateCharacter);
 
@@ -21,6 +28,7 @@ AVRiCCCharacter::AVRiCCCharacter()
 {
 	// Character doesnt have a rifle at start
 	bHasRifle = false;
+	Weapon = nullptr;
 	
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(55.f, 96.0f);
@@ -39,12 +47,19 @@ AVRiCCCharacter::AVRiCCCharacter()
 	Mesh1P->CastShadow = false;
 	//Mesh1P->SetRelativeRotation(FRotator(0.9f, -19.19f, 5.2f));
 	Mesh1P->SetRelativeLocation(FVector(-30.f, 0.f, -150.f));
+
+	HUDModel = CreateDefaultSubobject<UVRiCCHUDModelComponent>(TEXT("HUDModel"));
+
 	bReplicates = true;
 
-	VRiCC_ShotsPerRack = 8;
+	// carried until a weapon with its own definition is picked up
+	const FVRiCCWeaponStats DefaultWeapon;
+	VRiCC_ShotsPerRack = DefaultWeapon.ShotsPerRack;
 	VRiCC_ShotsLeft = VRiCC_ShotsPerRack;
-	VRiCC_AmmoRacks = 4;
+	VRiCC_AmmoRacks = DefaultWeapon.AmmoRacks;
 	VRiCC_Health = 1.0f;
+	CombatState = FVRiCCCombatState::Make(VRiCC_Health, VRiCC_ShotsLeft, VRiCC_AmmoRacks);
+	AmmoAckSequence = 0;
 }
 
 void AVRiCCCharacter::BeginPlay()
@@ -61,6 +76,29 @@ void AVRiCCCharacter::BeginPlay()
 		}
 	}
 	ShowHealth();
+
+	// nobody sees the arms on a dedicated server, only their bones would be evaluated
+	if (!VRiCC::IsPresentationEnabled(this))
+	{
+		Mesh1P->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+	}
+
+	// weapon traces skip pawns, every character is hit through its hitboxes instead.
+	// Only the server records a history of them to validate shots against
+	if (UVRiCCLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UVRiCCLagCompensationSubsystem>())
+	{
+		LagCompensation->RegisterCharacter(this);
+	}
+}
+
+void AVRiCCCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UVRiCCLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UVRiCCLagCompensationSubsystem>())
+	{
+		LagCompensation->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 //////////////////////////////////////////////////////////////////////////// Input
@@ -123,25 +161,130 @@ bool AVRiCCCharacter::GetHasRifle()
 	return bHasRifle;
 }
 
+void AVRiCCCharacter::ServerFireShots_Implementation(const FVRiCCFirePacket& Packet)
+{
+	if (Weapon != nullptr)
+	{
+		Weapon->ResolveShotPacket(Packet);
+	}
+}
+
+void AVRiCCCharacter::ServerReload_Implementation(uint16 Sequence)
+{
+	if (Weapon != nullptr)
+	{
+		Weapon->ResolveReload(Sequence);
+	}
+}
+
+void AVRiCCCharacter::AckAmmoChange(uint16 Sequence)
+{
+	if (HasAuthority() && Sequence != AmmoAckSequence)
+	{
+		AmmoAckSequence = Sequence;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AVRiCCCharacter, AmmoAckSequence, this);
+	}
+}
+
+FVRiCCHitboxPose AVRiCCCharacter::GetHitboxPose(double Time) const
+{
+	const UCapsuleComponent* Capsule = GetCapsuleComponent();
+
+	FVRiCCHitboxPose Pose;
+	Pose.Time = Time;
+	Pose.Center = FVector3f(Capsule->GetComponentLocation());
+	Pose.Radius = Capsule->GetScaledCapsuleRadius();
+	Pose.HalfHeight = Capsule->GetScaledCapsuleHalfHeight();
+	Pose.Yaw = GetActorRotation().Yaw;
+	return Pose;
+}
+
 void AVRiCCCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	// This tells UE that we want to replicate this variable
-	DOREPLIFETIME(AVRiCCCharacter, VRiCC_AmmoRacks);
-	DOREPLIFETIME(AVRiCCCharacter, VRiCC_ShotsLeft);
-	DOREPLIFETIME(AVRiCCCharacter, VRiCC_Health);
+	// push based, the net driver skips comparing it until CommitCombatState marks it dirty
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AVRiCCCharacter, CombatState, Params);
+
+	FDoRepLifetimeParams OwnerParams;
+	OwnerParams.bIsPushBased = true;
+	OwnerParams.Condition = COND_OwnerOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(AVRiCCCharacter, AmmoAckSequence, OwnerParams);
+}
+
+void AVRiCCCharacter::CommitCombatState()
+{
+	if (!HasAuthority())
+	{
+		return;
+	}
+
+	// changes below the wire precision do not cost a replication update
+	const FVRiCCCombatState NewState = FVRiCCCombatState::Make(VRiCC_Health, VRiCC_ShotsLeft, VRiCC_AmmoRacks);
+	if (NewState != CombatState)
+	{
+		CombatState = NewState;
+		MARK_PROPERTY_DIRTY_FROM_NAME(AVRiCCCharacter, CombatState, this);
+	}
+}
+
+void AVRiCCCharacter::OnRep_CombatState()
+{
+	VRiCC_Health = CombatState.GetHealth();
+	ShowHealth();
+
+	// the owning client predicts its own shots and reloads and only takes the server copy through reconciliation
+	if (IsLocallyControlled())
+	{
+		ReconcileAmmo();
+	}
+	else
+	{
+		VRiCC_ShotsLeft = CombatState.ShotsLeft;
+		VRiCC_AmmoRacks = CombatState.AmmoRacks;
+		if (Weapon != nullptr)
+		{
+			ShowAmmoInfo(Weapon->GetFiringMode());
+		}
+	}
+}
+
+void AVRiCCCharacter::OnRep_AmmoAckSequence()
+{
+	ReconcileAmmo();
+}
+
+void AVRiCCCharacter::ReconcileAmmo()
+{
+	if (Weapon != nullptr && IsLocallyControlled())
+	{
+		Weapon->ReconcileAmmo(CombatState.ShotsLeft, CombatState.AmmoRacks, AmmoAckSequence);
+	}
 }
 
 
+// HUD updates only where a HUD exists, the replicated state reaches clients without them
 void AVRiCCCharacter::ShowAmmoInfo(FiringMode fmode)
 {
-	ShowAmmoInfoEvent(VRiCC_ShotsPerRack, VRiCC_ShotsLeft, VRiCC_AmmoRacks, fmode);
+#if VRICC_WITH_PRESENTATION
+	if (VRiCC::IsPresentationEnabled(this))
+	{
+		HUDModel->SetAmmo(VRiCC_ShotsPerRack, VRiCC_ShotsLeft, VRiCC_AmmoRacks);
+		HUDModel->SetFiringMode(fmode);
+	}
+#endif
 }
 
 void AVRiCCCharacter::ShowHealth()
 {
-	ShowHealthEvent(VRiCC_Health);
+#if VRICC_WITH_PRESENTATION
+	if (VRiCC::IsPresentationEnabled(this))
+	{
+		HUDModel->SetHealth(VRiCC_Health);
+	}
+#endif
 }
 
 // BP event showing ammo on UI
@@ -162,8 +305,29 @@ void AVRiCCCharacter::ShowHealthEvent_Implementation(float Health)
 
 }
 
-// taking damage from lince trace hit, Damage is constant 0.1 
+// queues the hit with the damage subsystem, health changes once at the end of the frame
 float AVRiCCCharacter::TakeDamage(float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	VRICC_SCOPE_CYCLE(TakeDamage);
+
+	UVRiCCDamageSubsystem* DamageSubsystem = GetWorld()->GetSubsystem<UVRiCCDamageSubsystem>();
+	if (DamageSubsystem == nullptr)
+	{
+		ApplyFrameDamage(Damage);
+		return Damage;
+	}
+
+	FVRiCCDamageRecord Record;
+	Record.Victim = this;
+	Record.Instigator = EventInstigator;
+	Record.Causer = DamageCauser;
+	Record.Amount = Damage;
+	Record.Type = EVRiCCDamageType::Generic;
+	DamageSubsystem->QueueDamage(Record);
+	return Damage;
+}
+
+void AVRiCCCharacter::ApplyFrameDamage(float Damage)
 {
 	if (VRiCC_Health > 0)
 	{
@@ -173,10 +337,15 @@ float AVRiCCCharacter::TakeDamage(float Damage, FDamageEvent const& DamageEvent,
 	if (VRiCC_Health <= 0)
 	{
 		VRiCC_Health = 0;
-		// Die
 	}
 
+	CommitCombatState();
 
 	ShowHealth();
-	return 0;
+}
+
+// BP event for death handling
+void AVRiCCCharacter::DiedEvent_Implementation(AController* Killer)
+{
+
 }
\ No newline at end of file
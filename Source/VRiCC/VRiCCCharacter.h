@@ -5,6 +5,9 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Logging/LogMacros.h"
+#include "VRiCCLagCompensation.h"
+#include "VRiCCCombatState.h"
+#include "VRiCCFirePacket.h"
 #include "VRiCCCharacter.generated.h"
 
 class UInputComponent;
@@ -12,6 +15,8 @@ class USkeletalMeshComponent;
 class UCameraComponent;
 class UInputAction;
 class UInputMappingContext;
+class UTP_WeaponComponent;
+class UVRiCCHUDModelComponent;
 struct FInputActionValue;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogTemplateCharacter, Log, All);
@@ -28,10 +33,18 @@ class AVRiCCCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	/** Load test bots and input replays feed Move and Look like the input bindings do */
+	friend class UVRiCCBotComponent;
+	friend class UVRiCCInputRecorderComponent;
+
 	/** Pawn mesh: 1st person view (arms; seen only by self) */
 	UPROPERTY(VisibleDefaultsOnly, Category=Mesh)
 	USkeletalMeshComponent* Mesh1P;
 
+	/** Coalesces ammo and health changes into one HUD update per frame */
+	UPROPERTY(VisibleDefaultsOnly, Category = HUD)
+	UVRiCCHUDModelComponent* HUDModel;
+
 	/** First person camera */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* FirstPersonCameraComponent;
@@ -53,6 +66,7 @@ public:
 
 protected:
 	virtual void BeginPlay();
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 public:
 		
@@ -72,6 +86,29 @@ public:
 	UFUNCTION(BlueprintCallable, Category = Weapon)
 	bool GetHasRifle();
 
+	/** Weapon currently attached to this character */
+	void SetWeapon(UTP_WeaponComponent* NewWeapon) { Weapon = NewWeapon; }
+	UTP_WeaponComponent* GetWeapon() const { return Weapon; }
+
+	/** Sends a batch of shots to the server, which validates them and resolves the hits against rewound hitboxes */
+	UFUNCTION(Server, Reliable)
+	void ServerFireShots(const FVRiCCFirePacket& Packet);
+
+	/** Sends a reload the client already predicted, Sequence comes back through AmmoAckSequence */
+	UFUNCTION(Server, Reliable)
+	void ServerReload(uint16 Sequence);
+
+	/** Server only: acknowledges the owning client's predicted ammo changes up to Sequence */
+	void AckAmmoChange(uint16 Sequence);
+	uint16 GetAmmoAckSequence() const { return AmmoAckSequence; }
+
+	/** Hitbox history recorded by the lag compensation subsystem on the server */
+	FVRiCCHitboxHistory& GetHitboxHistory() { return HitboxHistory; }
+	const FVRiCCHitboxHistory& GetHitboxHistory() const { return HitboxHistory; }
+
+	/** Current capsule as a hitbox pose stamped with Time */
+	FVRiCCHitboxPose GetHitboxPose(double Time) const;
+
 protected:
 	/** Called for movement input */
 	void Move(const FInputActionValue& Value);
@@ -90,27 +127,65 @@ public:
 	/** Returns FirstPersonCameraComponent subobject **/
 	UCameraComponent* GetFirstPersonCameraComponent() const { return FirstPersonCameraComponent; }
 
-	UPROPERTY(Replicated, BlueprintReadWrite, Category = "Stats")
+	/** Working copies of the combat state, replicated through CombatState */
+	UPROPERTY(BlueprintReadWrite, Category = "Stats")
 	float VRiCC_Health;
 	
 	UPROPERTY(BlueprintReadWrite, Category = "Ammo")
 	int VRiCC_ShotsPerRack;
-	UPROPERTY(Replicated, BlueprintReadWrite, Category = "Ammo")
+	UPROPERTY(BlueprintReadWrite, Category = "Ammo")
 	int VRiCC_ShotsLeft;
-	UPROPERTY(Replicated, BlueprintReadWrite, Category = "Ammo")
+	UPROPERTY(BlueprintReadWrite, Category = "Ammo")
 	int VRiCC_AmmoRacks;
 
+	/** Server only: packs health and ammo into CombatState and marks it dirty if the packed values changed */
+	void CommitCombatState();
+
+	/** Write the current ammo and health into the HUD model, the widgets are updated once at the end of the frame */
 	void ShowAmmoInfo(FiringMode fmode);
 	void ShowHealth();
 
+	UVRiCCHUDModelComponent* GetHUDModel() const { return HUDModel; }
+
 	UFUNCTION(BlueprintNativeEvent, BluePrintCallable, Category = "Ammo")
 	void AttachWeaponHUD(USkeletalMeshComponent* SKM_Comp, FName Slot);
 	UFUNCTION(BlueprintNativeEvent, BluePrintCallable, Category = "Ammo")
 	void ShowAmmoInfoEvent(int ShotsPerAmmo, int ShotsLeft, int Ammo, FiringMode fireMode);
 	UFUNCTION(BlueprintNativeEvent, BluePrintCallable, Category = "Stats")
 	void ShowHealthEvent(float Health);
+	/** Called when health reaches zero, Killer is the instigator of the hit that crossed it */
+	UFUNCTION(BlueprintNativeEvent, BluePrintCallable, Category = "Stats")
+	void DiedEvent(AController* Killer);
+
+	/** Queues the damage with the damage subsystem, health changes once at the end of the frame */
 	UFUNCTION()
 	virtual float TakeDamage(float Damage, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser) override;
 
+	/** Applies every hit this character took in a frame as one health change, one combat state commit and one HUD write */
+	void ApplyFrameDamage(float Damage);
+
+	/** Owning client only: lets the weapon replay its unacknowledged ammo changes on top of the server state */
+	void ReconcileAmmo();
+
+protected:
+	UFUNCTION()
+	void OnRep_CombatState();
+
+	UFUNCTION()
+	void OnRep_AmmoAckSequence();
+
+private:
+	/** Push model replicated health and ammo, only sent when CommitCombatState marked it dirty */
+	UPROPERTY(ReplicatedUsing = OnRep_CombatState)
+	FVRiCCCombatState CombatState;
+
+	/** Last predicted ammo change of the owning client the server applied, only sent to the owner */
+	UPROPERTY(ReplicatedUsing = OnRep_AmmoAckSequence)
+	uint16 AmmoAckSequence;
+
+	UPROPERTY(Transient)
+	UTP_WeaponComponent* Weapon;
+
+	FVRiCCHitboxHistory HitboxHistory;
 };
 
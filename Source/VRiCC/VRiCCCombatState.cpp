@@ -0,0 +1,86 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCCombatState.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Serialization/BitWriter.h"
+
+FVRiCCCombatState FVRiCCCombatState::Make(float InHealth, int32 InShotsLeft, int32 InAmmoRacks)
+{
+	FVRiCCCombatState State;
+	State.QuantizedHealth = uint8(FMath::RoundToInt(FMath::Clamp(InHealth, 0.f, 1.f) * 255.f));
+	State.ShotsLeft = uint8(FMath::Clamp(InShotsLeft, 0, (1 << ShotsLeftBits) - 1));
+	State.AmmoRacks = uint8(FMath::Clamp(InAmmoRacks, 0, (1 << AmmoRacksBits) - 1));
+	return State;
+}
+
+bool FVRiCCCombatState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	Ar.SerializeBits(&QuantizedHealth, 8);
+
+	uint32 PackedShotsLeft = ShotsLeft;
+	uint32 PackedAmmoRacks = AmmoRacks;
+	Ar.SerializeInt(PackedShotsLeft, 1 << ShotsLeftBits);
+	Ar.SerializeInt(PackedAmmoRacks, 1 << AmmoRacksBits);
+
+	if (Ar.IsLoading())
+	{
+		ShotsLeft = uint8(PackedShotsLeft);
+		AmmoRacks = uint8(PackedAmmoRacks);
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+// Compares the serialized size and cost of the packed combat state with the three
+// separately replicated properties it replaced. The push model saving on property
+// comparison only shows up in a real net profile (stat net / Networking Insights).
+static FAutoConsoleCommand GCombatStateMeasureCommand(
+	TEXT("VRiCC.CombatState.Measure"),
+	TEXT("VRiCC.CombatState.Measure [NumCharacters=64]: bits and serialize time of the packed combat state versus float Health + int ShotsLeft + int AmmoRacks."),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 NumCharacters = FMath::Max(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 64, 1);
+
+		FRandomStream Random(NumCharacters);
+		TArray<FVRiCCCombatState> States;
+		States.Reserve(NumCharacters);
+		for (int32 Index = 0; Index < NumCharacters; ++Index)
+		{
+			States.Add(FVRiCCCombatState::Make(Random.FRand(), Random.RandRange(0, 8), Random.RandRange(0, 4)));
+		}
+
+		// legacy layout: every changed property writes its handle followed by the full value
+		double StartSeconds = FPlatformTime::Seconds();
+		FBitWriter LegacyWriter(0, true);
+		for (const FVRiCCCombatState& State : States)
+		{
+			for (uint32 Handle = 1; Handle <= 3; ++Handle)
+			{
+				LegacyWriter.SerializeIntPacked(Handle);
+			}
+			float Health = State.GetHealth();
+			int32 ShotsLeft = State.ShotsLeft;
+			int32 AmmoRacks = State.AmmoRacks;
+			LegacyWriter << Health << ShotsLeft << AmmoRacks;
+		}
+		const double LegacyMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+		// packed layout: one property handle and 20 bits
+		StartSeconds = FPlatformTime::Seconds();
+		FBitWriter PackedWriter(0, true);
+		for (FVRiCCCombatState& State : States)
+		{
+			uint32 Handle = 1;
+			PackedWriter.SerializeIntPacked(Handle);
+			bool bSuccess = true;
+			State.NetSerialize(PackedWriter, nullptr, bSuccess);
+		}
+		const double PackedMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+		UE_LOG(LogTemp, Display, TEXT("CombatState, %d characters: legacy %lld bits (%.1f/character, %.4fms), packed %lld bits (%.1f/character, %.4fms)"),
+			NumCharacters,
+			LegacyWriter.GetNumBits(), double(LegacyWriter.GetNumBits()) / NumCharacters, LegacyMs,
+			PackedWriter.GetNumBits(), double(PackedWriter.GetNumBits()) / NumCharacters, PackedMs);
+	}));
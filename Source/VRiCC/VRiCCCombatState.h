@@ -0,0 +1,52 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRiCCCombatState.generated.h"
+
+/**
+ * Health and ammo of a character, replicated as one push model property.
+ * Health travels as 8 bits and the ammo counts are bit-packed, 20 bits per update in total.
+ */
+USTRUCT(BlueprintType)
+struct VRICC_API FVRiCCCombatState
+{
+	GENERATED_BODY()
+
+	static constexpr uint32 ShotsLeftBits = 7;
+	static constexpr uint32 AmmoRacksBits = 5;
+
+	/** Health in 1/255 steps of the 0..1 range */
+	UPROPERTY()
+	uint8 QuantizedHealth = 255;
+
+	UPROPERTY()
+	uint8 ShotsLeft = 0;
+
+	UPROPERTY()
+	uint8 AmmoRacks = 0;
+
+	/** Quantizes and clamps the gameplay values into their wire ranges */
+	static FVRiCCCombatState Make(float InHealth, int32 InShotsLeft, int32 InAmmoRacks);
+
+	float GetHealth() const { return QuantizedHealth / 255.f; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	bool operator==(const FVRiCCCombatState& Other) const
+	{
+		return QuantizedHealth == Other.QuantizedHealth && ShotsLeft == Other.ShotsLeft && AmmoRacks == Other.AmmoRacks;
+	}
+	bool operator!=(const FVRiCCCombatState& Other) const { return !(*this == Other); }
+};
+
+template<>
+struct TStructOpsTypeTraits<FVRiCCCombatState> : public TStructOpsTypeTraitsBase2<FVRiCCCombatState>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdenticalViaEquality = true,
+	};
+};
@@ -0,0 +1,139 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCDamage.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCStats.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static FAutoConsoleCommandWithWorld GDamageStatsCommand(
+	TEXT("VRiCC.Damage.Stats"),
+	TEXT("Prints how many hits the damage subsystem applied and how many were folded into another hit on the same victim."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCDamageSubsystem* DamageSubsystem = World != nullptr ? World->GetSubsystem<UVRiCCDamageSubsystem>() : nullptr)
+		{
+			const FVRiCCDamageStats& Stats = DamageSubsystem->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("Damage: total %llu, folded %llu, kills %llu, last frame %d hits on %d victims in %.3fms"),
+				Stats.TotalRecords, Stats.TotalFolded, Stats.Kills, Stats.RecordsLastFrame, Stats.VictimsLastFrame, Stats.ApplyMs);
+		}
+	}));
+
+bool UVRiCCDamageSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UVRiCCDamageSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// after the actor tick groups and the tickable subsystems, so the shot resolver's hits of this frame are in
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UVRiCCDamageSubsystem::OnWorldPostActorTick);
+}
+
+void UVRiCCDamageSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	Super::Deinitialize();
+}
+
+void UVRiCCDamageSubsystem::QueueDamage(const FVRiCCDamageRecord& Record)
+{
+	if (Record.Victim.IsValid() && Record.Amount > 0.f)
+	{
+		VRICC_COUNT(DamageEvents, 1);
+		Pending.Add(Record);
+	}
+}
+
+void UVRiCCDamageSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		ApplyPending();
+	}
+}
+
+void UVRiCCDamageSubsystem::ApplyPending()
+{
+	if (Pending.Num() == 0)
+	{
+		return;
+	}
+
+	VRICC_SCOPE_CYCLE(ApplyDamage);
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// death handlers may queue more damage, it lands in an empty Pending and is applied next frame
+	TArray<FVRiCCDamageRecord> Records = MoveTemp(Pending);
+
+	// records stay in queue order, so the hit that crosses zero and its instigator do not depend on the folding
+	struct FVictimDamage
+	{
+		AVRiCCCharacter* Victim = nullptr;
+		float StartHealth = 0.f;
+		float Amount = 0.f;
+		bool bKilled = false;
+		TWeakObjectPtr<AController> Killer;
+		TWeakObjectPtr<AActor> Causer;
+	};
+	TArray<FVictimDamage, TInlineAllocator<16>> Victims;
+
+	for (const FVRiCCDamageRecord& Record : Records)
+	{
+		AVRiCCCharacter* Victim = Record.Victim.Get();
+		if (Victim == nullptr)
+		{
+			continue;
+		}
+
+		FVictimDamage* Damage = Victims.FindByPredicate([Victim](const FVictimDamage& Entry) { return Entry.Victim == Victim; });
+		if (Damage == nullptr)
+		{
+			Damage = &Victims.AddDefaulted_GetRef();
+			Damage->Victim = Victim;
+			Damage->StartHealth = Victim->VRiCC_Health;
+		}
+		else
+		{
+			Stats.TotalFolded++;
+		}
+
+		const bool bWasAlive = Damage->StartHealth - Damage->Amount > 0.f;
+		Damage->Amount += Record.Amount;
+		if (bWasAlive && Damage->StartHealth - Damage->Amount <= 0.f)
+		{
+			Damage->bKilled = true;
+			Damage->Killer = Record.Instigator;
+			Damage->Causer = Record.Causer;
+		}
+	}
+
+	for (const FVictimDamage& Damage : Victims)
+	{
+		Damage.Victim->ApplyFrameDamage(Damage.Amount);
+
+		if (Damage.bKilled)
+		{
+			Stats.Kills++;
+			AController* Killer = Damage.Killer.Get();
+			AActor* Causer = Damage.Causer.Get();
+			Damage.Victim->DiedEvent(Killer);
+			OnCharacterKilled.Broadcast(Damage.Victim, Killer, Causer);
+		}
+	}
+
+	Stats.RecordsLastFrame = Records.Num();
+	Stats.VictimsLastFrame = Victims.Num();
+	Stats.TotalRecords += Records.Num();
+	Stats.ApplyMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+	// keep the allocation for the next frame unless a handler already queued into a new one
+	if (Pending.Num() == 0)
+	{
+		Records.Reset();
+		Pending = MoveTemp(Records);
+	}
+}
@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCHitboxKernel.h"
+#include "VRiCCDamage.generated.h"
+
+class AVRiCCCharacter;
+
+/** Where a damage record came from */
+enum class EVRiCCDamageType : uint8
+{
+	/** Validated hitscan shot */
+	Shot,
+	/** Anything that went through AActor::TakeDamage */
+	Generic,
+};
+
+/** One hit waiting for the end of the frame */
+struct FVRiCCDamageRecord
+{
+	TWeakObjectPtr<AVRiCCCharacter> Victim;
+	TWeakObjectPtr<AController> Instigator;
+	TWeakObjectPtr<AActor> Causer;
+	float Amount = 0.f;
+	EVRiCCDamageType Type = EVRiCCDamageType::Generic;
+	EVRiCCBodyPart BodyPart = EVRiCCBodyPart::None;
+};
+
+/** Counters of the damage subsystem, "last frame" values are overwritten every frame damage was applied */
+struct FVRiCCDamageStats
+{
+	int32 RecordsLastFrame = 0;
+	int32 VictimsLastFrame = 0;
+	uint64 TotalRecords = 0;
+	/** Records that rode along with an earlier hit on the same victim in the same frame */
+	uint64 TotalFolded = 0;
+	uint64 Kills = 0;
+	double ApplyMs = 0.0;
+};
+
+DECLARE_MULTICAST_DELEGATE_ThreeParams(FVRiCCOnCharacterKilled, AVRiCCCharacter* /*Victim*/, AController* /*Killer*/, AActor* /*Causer*/);
+
+/**
+ * Collects every hit of a frame and applies them once the actors and tickables are done.
+ * Hits on the same victim are folded into one health change, so each victim costs one
+ * combat state dirty and one HUD write per frame however many bullets it took.
+ */
+UCLASS()
+class VRICC_API UVRiCCDamageSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Queues a hit, applied with every other hit of the frame after all ticks ran */
+	void QueueDamage(const FVRiCCDamageRecord& Record);
+
+	/** Broadcast when a character's health reaches zero, with the instigator of the hit that crossed it */
+	FVRiCCOnCharacterKilled OnCharacterKilled;
+
+	const FVRiCCDamageStats& GetStats() const { return Stats; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/** Folds the queued records per victim and applies them */
+	void ApplyPending();
+
+	TArray<FVRiCCDamageRecord> Pending;
+
+	FDelegateHandle PostActorTickHandle;
+
+	FVRiCCDamageStats Stats;
+};
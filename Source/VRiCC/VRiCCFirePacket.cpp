@@ -0,0 +1,160 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCFirePacket.h"
+#include "Engine/NetSerialization.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Serialization/BitWriter.h"
+
+namespace VRiCCFirePacket
+{
+	/** Maps small signed deltas to small unsigned values so SerializeIntPacked keeps them short */
+	static uint32 ZigZag(int32 Value)
+	{
+		return (uint32(Value) << 1) ^ uint32(Value >> 31);
+	}
+
+	static int32 UnZigZag(uint32 Value)
+	{
+		return int32(Value >> 1) ^ -int32(Value & 1);
+	}
+
+	static void SerializeSigned(FArchive& Ar, int32& Value)
+	{
+		uint32 Packed = ZigZag(Value);
+		Ar.SerializeIntPacked(Packed);
+		Value = UnZigZag(Packed);
+	}
+}
+
+void FVRiCCFirePacket::AddShot(const FVector& Origin, const FVector& Direction, double ShotTime)
+{
+	if (IsFull())
+	{
+		return;
+	}
+
+	if (Shots.Num() == 0)
+	{
+		BaseTime = ShotTime;
+	}
+
+	const FRotator Rotation = Direction.Rotation();
+
+	FShot& Shot = Shots.AddDefaulted_GetRef();
+	Shot.Origin = FIntVector(FMath::RoundToInt(Origin.X), FMath::RoundToInt(Origin.Y), FMath::RoundToInt(Origin.Z));
+	Shot.Pitch = FRotator::CompressAxisToShort(Rotation.Pitch);
+	Shot.Yaw = FRotator::CompressAxisToShort(Rotation.Yaw);
+	Shot.TimeOffset = uint32(FMath::Max(FMath::RoundToInt64((ShotTime - BaseTime) / TimeStep), int64(0)));
+}
+
+void FVRiCCFirePacket::GetShot(int32 Index, FVector& OutOrigin, FVector& OutDirection, double& OutShotTime) const
+{
+	const FShot& Shot = Shots[Index];
+	OutOrigin = FVector(Shot.Origin);
+	OutDirection = FRotator(FRotator::DecompressAxisFromShort(Shot.Pitch), FRotator::DecompressAxisFromShort(Shot.Yaw), 0.0).Vector();
+	OutShotTime = BaseTime + Shot.TimeOffset * TimeStep;
+}
+
+bool FVRiCCFirePacket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 NumShots = Shots.Num();
+	Ar.SerializeInt(NumShots, MaxShots + 1);
+	if (Ar.IsLoading())
+	{
+		Shots.SetNum(NumShots);
+	}
+
+	if (NumShots > 0)
+	{
+		Ar << Sequence;
+		Ar << BaseTime;
+	}
+
+	FShot Previous;
+	for (FShot& Shot : Shots)
+	{
+		int32 OriginDelta[3] = { Shot.Origin.X - Previous.Origin.X, Shot.Origin.Y - Previous.Origin.Y, Shot.Origin.Z - Previous.Origin.Z };
+		int32 PitchDelta = int16(Shot.Pitch - Previous.Pitch);
+		int32 YawDelta = int16(Shot.Yaw - Previous.Yaw);
+		uint32 TimeDelta = Shot.TimeOffset - Previous.TimeOffset;
+
+		// shots of one frame leave the same muzzle, that case costs a single bit
+		uint8 bSameOrigin = OriginDelta[0] == 0 && OriginDelta[1] == 0 && OriginDelta[2] == 0;
+		Ar.SerializeBits(&bSameOrigin, 1);
+		if (!bSameOrigin)
+		{
+			VRiCCFirePacket::SerializeSigned(Ar, OriginDelta[0]);
+			VRiCCFirePacket::SerializeSigned(Ar, OriginDelta[1]);
+			VRiCCFirePacket::SerializeSigned(Ar, OriginDelta[2]);
+		}
+		else
+		{
+			OriginDelta[0] = OriginDelta[1] = OriginDelta[2] = 0;
+		}
+		VRiCCFirePacket::SerializeSigned(Ar, PitchDelta);
+		VRiCCFirePacket::SerializeSigned(Ar, YawDelta);
+		Ar.SerializeIntPacked(TimeDelta);
+
+		if (Ar.IsLoading())
+		{
+			Shot.Origin = Previous.Origin + FIntVector(OriginDelta[0], OriginDelta[1], OriginDelta[2]);
+			Shot.Pitch = uint16(Previous.Pitch + PitchDelta);
+			Shot.Yaw = uint16(Previous.Yaw + YawDelta);
+			Shot.TimeOffset = Previous.TimeOffset + TimeDelta;
+		}
+		Previous = Shot;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+// Payload bits of the same shots sent as fire packets versus one ServerFireShot(FVector_NetQuantize,
+// FVector_NetQuantizeNormal, double) RPC each. Every RPC also pays its own function and bunch headers
+// on top of the payload, so the RPC count is printed next to the bits.
+static FAutoConsoleCommand GFirePacketMeasureCommand(
+	TEXT("VRiCC.FirePacket.Measure"),
+	TEXT("VRiCC.FirePacket.Measure [ShotsPerPacket=4] [NumPackets=256]: payload bits of fire packets versus one RPC per shot."),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 ShotsPerPacket = FMath::Clamp(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 4, 1, FVRiCCFirePacket::MaxShots);
+		const int32 NumPackets = FMath::Max(Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 256, 1);
+
+		FRandomStream Random(ShotsPerPacket);
+		FBitWriter PacketWriter(0, true);
+		FBitWriter PerShotWriter(0, true);
+		double ShotTime = 100.0;
+
+		for (int32 PacketIndex = 0; PacketIndex < NumPackets; ++PacketIndex)
+		{
+			// a burst from one muzzle pose with a little recoil, at 1200 rpm
+			FVector Origin(Random.FRandRange(-20000.f, 20000.f), Random.FRandRange(-20000.f, 20000.f), Random.FRandRange(0.f, 2000.f));
+			FVector Direction = Random.GetUnitVector();
+
+			FVRiCCFirePacket Packet;
+			for (int32 ShotIndex = 0; ShotIndex < ShotsPerPacket; ++ShotIndex)
+			{
+				Packet.AddShot(Origin, Direction, ShotTime);
+
+				bool bSuccess = true;
+				FVector_NetQuantize QuantizedOrigin(Origin);
+				FVector_NetQuantizeNormal QuantizedDirection(Direction);
+				QuantizedOrigin.NetSerialize(PerShotWriter, nullptr, bSuccess);
+				QuantizedDirection.NetSerialize(PerShotWriter, nullptr, bSuccess);
+				PerShotWriter << ShotTime;
+
+				Direction = (Direction + Random.GetUnitVector() * 0.01f).GetSafeNormal();
+				ShotTime += 0.05;
+			}
+
+			bool bSuccess = true;
+			Packet.NetSerialize(PacketWriter, nullptr, bSuccess);
+		}
+
+		const int32 NumShots = NumPackets * ShotsPerPacket;
+		UE_LOG(LogTemp, Display, TEXT("FirePacket, %d shots: packets %lld bits in %d RPCs (%.1f bits/shot), per shot RPC %lld bits in %d RPCs (%.1f bits/shot)"),
+			NumShots,
+			PacketWriter.GetNumBits(), NumPackets, double(PacketWriter.GetNumBits()) / NumShots,
+			PerShotWriter.GetNumBits(), NumShots, double(PerShotWriter.GetNumBits()) / NumShots);
+	}));
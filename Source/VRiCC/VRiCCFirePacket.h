@@ -0,0 +1,62 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VRiCCFirePacket.generated.h"
+
+/**
+ * Shots a client fired since its last packet, sent to the server in one RPC.
+ * Origins are quantized to whole units, directions to 16 bit pitch and yaw, times to 0.1ms steps.
+ * On the wire the first shot is absolute and every following shot a zigzag, packed delta against
+ * the one before, so a burst fired from one muzzle pose costs a few bits per extra shot.
+ */
+USTRUCT()
+struct VRICC_API FVRiCCFirePacket
+{
+	GENERATED_BODY()
+
+	static constexpr int32 MaxShots = 32;
+
+	/** Seconds per step of the shot time offsets */
+	static constexpr double TimeStep = 0.0001;
+
+	void AddShot(const FVector& Origin, const FVector& Direction, double ShotTime);
+	void GetShot(int32 Index, FVector& OutOrigin, FVector& OutDirection, double& OutShotTime) const;
+
+	int32 Num() const { return Shots.Num(); }
+	bool IsFull() const { return Shots.Num() >= MaxShots; }
+	void Reset() { Shots.Reset(); BaseTime = 0.0; Sequence = 0; }
+
+	/** Sequence number of the last predicted ammo change in this packet, acknowledged back by the server */
+	void SetSequence(uint16 NewSequence) { Sequence = NewSequence; }
+	uint16 GetSequence() const { return Sequence; }
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+private:
+	struct FShot
+	{
+		FIntVector Origin = FIntVector::ZeroValue;
+		uint16 Pitch = 0;
+		uint16 Yaw = 0;
+		/** Steps of TimeStep after BaseTime */
+		uint32 TimeOffset = 0;
+	};
+
+	/** Time of the first shot */
+	double BaseTime = 0.0;
+
+	uint16 Sequence = 0;
+
+	TArray<FShot, TInlineAllocator<8>> Shots;
+};
+
+template<>
+struct TStructOpsTypeTraits<FVRiCCFirePacket> : public TStructOpsTypeTraitsBase2<FVRiCCFirePacket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
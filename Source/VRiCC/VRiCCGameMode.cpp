@@ -1,14 +1,85 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "VRiCCGameMode.h"
+#include "VRiCCAssetManager.h"
 #include "VRiCCCharacter.h"
-#include "UObject/ConstructorHelpers.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
 
 AVRiCCGameMode::AVRiCCGameMode()
 	: Super()
 {
-	// set default pawn class to our Blueprinted character
-	static ConstructorHelpers::FClassFinder<APawn> PlayerPawnClassFinder(TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter"));
-	DefaultPawnClass = PlayerPawnClassFinder.Class;
+	// set default pawn class to our Blueprinted character, resolved asynchronously in InitGame
+	DefaultPawnSoftClass = TSoftClassPtr<APawn>(FSoftObjectPath(TEXT("/Game/FirstPerson/Blueprints/BP_FirstPersonCharacter.BP_FirstPersonCharacter_C")));
+}
+
+void AVRiCCGameMode::InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage)
+{
+	Super::InitGame(MapName, Options, ErrorMessage);
+
+	if (DefaultPawnSoftClass.IsNull())
+	{
+		return;
+	}
+
+	// usually already streamed by the startup preload, otherwise players wait for it instead of the map load
+	DefaultPawnHandle = UAssetManager::GetStreamableManager().RequestAsyncLoad(DefaultPawnSoftClass.ToSoftObjectPath(),
+		FStreamableDelegate::CreateUObject(this, &AVRiCCGameMode::OnDefaultPawnClassLoaded), FStreamableManager::AsyncLoadHighPriority);
+	if (!DefaultPawnHandle.IsValid() || DefaultPawnHandle->HasLoadCompleted())
+	{
+		OnDefaultPawnClassLoaded();
+	}
+}
+
+void AVRiCCGameMode::StartPlay()
+{
+	Super::StartPlay();
+
+	MarkServerPlayable();
+}
+
+void AVRiCCGameMode::HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer)
+{
+	if (DefaultPawnHandle.IsValid() && !DefaultPawnHandle->HasLoadCompleted())
+	{
+		PendingPlayers.Add(NewPlayer);
+		return;
+	}
+
+	Super::HandleStartingNewPlayer_Implementation(NewPlayer);
+}
+
+void AVRiCCGameMode::OnDefaultPawnClassLoaded()
+{
+	if (UClass* PawnClass = DefaultPawnSoftClass.Get())
+	{
+		DefaultPawnClass = PawnClass;
+	}
+
+	// called from InitGame as well as by the handle, whichever comes first starts the waiting players
+	TArray<TWeakObjectPtr<APlayerController>> Players = MoveTemp(PendingPlayers);
+	for (const TWeakObjectPtr<APlayerController>& Player : Players)
+	{
+		if (APlayerController* PlayerController = Player.Get())
+		{
+			Super::HandleStartingNewPlayer_Implementation(PlayerController);
+		}
+	}
+
+	MarkServerPlayable();
+}
+
+void AVRiCCGameMode::MarkServerPlayable()
+{
+	if (!IsRunningDedicatedServer() || !GetWorld()->HasBegunPlay() || (DefaultPawnHandle.IsValid() && !DefaultPawnHandle->HasLoadCompleted()))
+	{
+		return;
+	}
 
+	if (UVRiCCAssetManager* AssetManager = UVRiCCAssetManager::Get())
+	{
+		AssetManager->MarkPlayable();
+	}
 }
@@ -6,6 +6,8 @@
 #include "GameFramework/GameModeBase.h"
 #include "VRiCCGameMode.generated.h"
 
+struct FStreamableHandle;
+
 UCLASS(minimalapi)
 class AVRiCCGameMode : public AGameModeBase
 {
@@ -13,7 +15,23 @@ class AVRiCCGameMode : public AGameModeBase
 
 public:
 	AVRiCCGameMode();
-};
 
+	virtual void InitGame(const FString& MapName, const FString& Options, FString& ErrorMessage) override;
+	virtual void StartPlay() override;
+	virtual void HandleStartingNewPlayer_Implementation(APlayerController* NewPlayer) override;
+
+	/** Pawn for players, streamed in while the map loads instead of loaded together with the game mode class */
+	UPROPERTY(EditDefaultsOnly, Category = Classes)
+	TSoftClassPtr<APawn> DefaultPawnSoftClass;
 
+private:
+	void OnDefaultPawnClassLoaded();
 
+	/** A dedicated server is playable once play started and the pawn class is in memory */
+	void MarkServerPlayable();
+
+	TSharedPtr<FStreamableHandle> DefaultPawnHandle;
+
+	/** Players that joined before the pawn class finished streaming, started once it has */
+	TArray<TWeakObjectPtr<APlayerController>> PendingPlayers;
+};
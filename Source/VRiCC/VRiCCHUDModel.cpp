@@ -0,0 +1,134 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCHUDModel.h"
+#include "VRiCCStats.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static FAutoConsoleCommandWithWorld GHUDModelStatsCommand(
+	TEXT("VRiCC.HUD.Stats"),
+	TEXT("Prints how many HUD writes of the local character were pushed to Blueprint and how many were coalesced."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const APlayerController* PlayerController = World != nullptr ? World->GetFirstPlayerController() : nullptr;
+		const APawn* Pawn = PlayerController != nullptr ? PlayerController->GetPawn() : nullptr;
+		if (const UVRiCCHUDModelComponent* HUDModel = Pawn != nullptr ? Pawn->FindComponentByClass<UVRiCCHUDModelComponent>() : nullptr)
+		{
+			const FVRiCCHUDModelStats& Stats = HUDModel->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("HUD: writes %llu, unchanged %llu, coalesced %llu, pushes %llu"),
+				Stats.Writes, Stats.Unchanged, Stats.Coalesced, Stats.Pushes);
+		}
+	}));
+
+UVRiCCHUDModelComponent::UVRiCCHUDModelComponent()
+{
+	// after gameplay so every write of the frame lands in one push, and only while something is pending
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+
+	ShotsPerRack = 0;
+	ShotsLeft = 0;
+	AmmoRacks = 0;
+	CurrentFiringMode = FiringMode::FiringMode_Single;
+	Health = 0.f;
+	DirtyFields = EVRiCCHUDField::None;
+}
+
+void UVRiCCHUDModelComponent::MarkDirty(EVRiCCHUDField Field)
+{
+	Stats.Writes++;
+
+	// a push is already pending this frame, the new value simply rides along
+	if (DirtyFields != EVRiCCHUDField::None)
+	{
+		Stats.Coalesced++;
+	}
+	else
+	{
+		SetComponentTickEnabled(true);
+	}
+	DirtyFields |= Field;
+}
+
+void UVRiCCHUDModelComponent::MarkAllDirty()
+{
+	MarkDirty(EVRiCCHUDField::Ammo | EVRiCCHUDField::FiringMode | EVRiCCHUDField::Health);
+}
+
+void UVRiCCHUDModelComponent::SetAmmo(int32 NewShotsPerRack, int32 NewShotsLeft, int32 NewAmmoRacks)
+{
+	if (NewShotsPerRack == ShotsPerRack && NewShotsLeft == ShotsLeft && NewAmmoRacks == AmmoRacks)
+	{
+		Stats.Unchanged++;
+		return;
+	}
+
+	ShotsPerRack = NewShotsPerRack;
+	ShotsLeft = NewShotsLeft;
+	AmmoRacks = NewAmmoRacks;
+	MarkDirty(EVRiCCHUDField::Ammo);
+}
+
+void UVRiCCHUDModelComponent::SetFiringMode(FiringMode NewFiringMode)
+{
+	if (NewFiringMode == CurrentFiringMode)
+	{
+		Stats.Unchanged++;
+		return;
+	}
+
+	CurrentFiringMode = NewFiringMode;
+	MarkDirty(EVRiCCHUDField::FiringMode);
+}
+
+void UVRiCCHUDModelComponent::SetHealth(float NewHealth)
+{
+	if (NewHealth == Health)
+	{
+		Stats.Unchanged++;
+		return;
+	}
+
+	Health = NewHealth;
+	MarkDirty(EVRiCCHUDField::Health);
+}
+
+void UVRiCCHUDModelComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	Flush();
+}
+
+void UVRiCCHUDModelComponent::Flush()
+{
+	VRICC_SCOPE_CYCLE(HUDFlush);
+
+	SetComponentTickEnabled(false);
+
+	AVRiCCCharacter* Character = Cast<AVRiCCCharacter>(GetOwner());
+	if (Character == nullptr || DirtyFields == EVRiCCHUDField::None)
+	{
+		DirtyFields = EVRiCCHUDField::None;
+		return;
+	}
+
+	// ammo and firing mode share one widget event
+	if (EnumHasAnyFlags(DirtyFields, EVRiCCHUDField::Ammo | EVRiCCHUDField::FiringMode))
+	{
+		Character->ShowAmmoInfoEvent(ShotsPerRack, ShotsLeft, AmmoRacks, CurrentFiringMode);
+		Stats.Pushes++;
+		VRICC_COUNT(HUDPushes, 1);
+	}
+
+	if (EnumHasAnyFlags(DirtyFields, EVRiCCHUDField::Health))
+	{
+		Character->ShowHealthEvent(Health);
+		Stats.Pushes++;
+		VRICC_COUNT(HUDPushes, 1);
+	}
+
+	DirtyFields = EVRiCCHUDField::None;
+}
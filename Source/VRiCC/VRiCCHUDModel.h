@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCHUDModel.generated.h"
+
+/** Fields of the HUD model changed since the last push */
+enum class EVRiCCHUDField : uint8
+{
+	None = 0,
+	Ammo = 1 << 0,
+	FiringMode = 1 << 1,
+	Health = 1 << 2,
+};
+ENUM_CLASS_FLAGS(EVRiCCHUDField);
+
+/** How much HUD work the model saved, for VRiCC.HUD.Stats */
+struct FVRiCCHUDModelStats
+{
+	/** Set calls that changed a value */
+	uint64 Writes = 0;
+	/** Set calls that only repeated the current value */
+	uint64 Unchanged = 0;
+	/** Writes folded into a push that was already pending */
+	uint64 Coalesced = 0;
+	/** Blueprint events actually sent to the HUD widgets */
+	uint64 Pushes = 0;
+};
+
+/**
+ * Native view model between the character and its HUD widgets (UI_WeaponHUD, UI_HealthMeter).
+ * Shots, reloads and hits only write values here, the model sends the Blueprint events
+ * ShowAmmoInfoEvent and ShowHealthEvent at most once per frame and only for fields that changed.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class VRICC_API UVRiCCHUDModelComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UVRiCCHUDModelComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	void SetAmmo(int32 ShotsPerRack, int32 ShotsLeft, int32 AmmoRacks);
+	void SetFiringMode(FiringMode NewFiringMode);
+	void SetHealth(float NewHealth);
+
+	/** Pushes every field on the next flush, for widgets that were just created */
+	void MarkAllDirty();
+
+	bool IsDirty() const { return DirtyFields != EVRiCCHUDField::None; }
+	const FVRiCCHUDModelStats& GetStats() const { return Stats; }
+
+private:
+	void MarkDirty(EVRiCCHUDField Field);
+
+	/** Sends the Blueprint events for the pending fields */
+	void Flush();
+
+	int32 ShotsPerRack;
+	int32 ShotsLeft;
+	int32 AmmoRacks;
+	FiringMode CurrentFiringMode;
+	float Health;
+
+	EVRiCCHUDField DirtyFields;
+
+	FVRiCCHUDModelStats Stats;
+};
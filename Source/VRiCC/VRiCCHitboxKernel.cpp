@@ -0,0 +1,186 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCHitboxKernel.h"
+
+//////////////////////////////////////////////////////////////////////////
+// FVRiCCCapsuleSoA
+
+void FVRiCCCapsuleSoA::Reset()
+{
+	CenterX.Reset();
+	CenterY.Reset();
+	CenterZ.Reset();
+	Radius.Reset();
+	SegmentHalf.Reset();
+	NumCapsules = 0;
+}
+
+int32 FVRiCCCapsuleSoA::Add(const FVector3f& Center, float InRadius, float InSegmentHalf)
+{
+	// the padding lanes of the last register are overwritten first
+	if (NumCapsules == CenterX.Num())
+	{
+		const int32 NewNum = NumCapsules + Lanes;
+		CenterX.SetNumUninitialized(NewNum);
+		CenterY.SetNumUninitialized(NewNum);
+		CenterZ.SetNumUninitialized(NewNum);
+		Radius.SetNumUninitialized(NewNum);
+		SegmentHalf.SetNumUninitialized(NewNum);
+		for (int32 Index = NumCapsules; Index < NewNum; ++Index)
+		{
+			CenterX[Index] = CenterY[Index] = CenterZ[Index] = 0.f;
+			Radius[Index] = -1.f;
+			SegmentHalf[Index] = 0.f;
+		}
+	}
+
+	CenterX[NumCapsules] = Center.X;
+	CenterY[NumCapsules] = Center.Y;
+	CenterZ[NumCapsules] = Center.Z;
+	Radius[NumCapsules] = InRadius;
+	SegmentHalf[NumCapsules] = FMath::Max(InSegmentHalf, 0.f);
+	return NumCapsules++;
+}
+
+void FVRiCCCapsuleSoA::IntersectRayAll(const FVector& Origin, const FVector3f& Direction, TArrayView<float> OutDistances) const
+{
+	check(OutDistances.Num() >= CenterX.Num());
+
+	const VectorRegister4Float OriginX = VectorSetFloat1(float(Origin.X));
+	const VectorRegister4Float OriginY = VectorSetFloat1(float(Origin.Y));
+	const VectorRegister4Float OriginZ = VectorSetFloat1(float(Origin.Z));
+	const VectorRegister4Float DirX = VectorSetFloat1(Direction.X);
+	const VectorRegister4Float DirY = VectorSetFloat1(Direction.Y);
+	const VectorRegister4Float DirZ = VectorSetFloat1(Direction.Z);
+
+	// a vertical ray cannot enter the cylinder body, only the caps
+	const float DirXYSq = Direction.X * Direction.X + Direction.Y * Direction.Y;
+	const bool bTestBody = DirXYSq > UE_KINDA_SMALL_NUMBER;
+	const VectorRegister4Float BodyA = VectorSetFloat1(DirXYSq);
+	const VectorRegister4Float BodyInvA = VectorSetFloat1(bTestBody ? 1.f / DirXYSq : 0.f);
+
+	const VectorRegister4Float Zero = VectorZeroFloat();
+	const VectorRegister4Float Miss = VectorSetFloat1(UE_BIG_NUMBER);
+
+	for (int32 Base = 0; Base < CenterX.Num(); Base += Lanes)
+	{
+		const VectorRegister4Float R = VectorLoad(&Radius[Base]);
+		const VectorRegister4Float S = VectorLoad(&SegmentHalf[Base]);
+		const VectorRegister4Float RSq = VectorMultiply(R, R);
+		const VectorRegister4Float RealLanes = VectorCompareGT(R, Zero);
+
+		// ray origin relative to the capsule center
+		const VectorRegister4Float RelX = VectorSubtract(OriginX, VectorLoad(&CenterX[Base]));
+		const VectorRegister4Float RelY = VectorSubtract(OriginY, VectorLoad(&CenterY[Base]));
+		const VectorRegister4Float RelZ = VectorSubtract(OriginZ, VectorLoad(&CenterZ[Base]));
+		const VectorRegister4Float RelXYSq = VectorMultiplyAdd(RelX, RelX, VectorMultiply(RelY, RelY));
+		const VectorRegister4Float HalfBXY = VectorMultiplyAdd(RelX, DirX, VectorMultiply(RelY, DirY));
+
+		VectorRegister4Float Distance = Miss;
+
+		// cylinder body: circle test in XY, the hit counts if it lies between the cap centers
+		if (bTestBody)
+		{
+			const VectorRegister4Float C = VectorSubtract(RelXYSq, RSq);
+			const VectorRegister4Float Discriminant = VectorSubtract(VectorMultiply(HalfBXY, HalfBXY), VectorMultiply(BodyA, C));
+			const VectorRegister4Float Root = VectorSqrt(VectorMax(Discriminant, Zero));
+			const VectorRegister4Float T = VectorMultiply(VectorSubtract(VectorNegate(HalfBXY), Root), BodyInvA);
+			const VectorRegister4Float Z = VectorMultiplyAdd(T, DirZ, RelZ);
+
+			VectorRegister4Float Valid = VectorBitwiseAnd(VectorCompareGE(Discriminant, Zero), VectorCompareGE(T, Zero));
+			Valid = VectorBitwiseAnd(Valid, VectorBitwiseAnd(VectorCompareGE(Z, VectorNegate(S)), VectorCompareLE(Z, S)));
+			Distance = VectorSelect(Valid, T, Distance);
+
+			// a ray starting inside the body hits at distance 0, like a start penetrating physics trace
+			const VectorRegister4Float Inside = VectorBitwiseAnd(VectorCompareLE(C, Zero), VectorBitwiseAnd(VectorCompareGE(RelZ, VectorNegate(S)), VectorCompareLE(RelZ, S)));
+			Distance = VectorSelect(Inside, Zero, Distance);
+		}
+
+		// hemisphere caps: sphere tests around both ends of the segment
+		for (const float CapSign : { -1.f, 1.f })
+		{
+			const VectorRegister4Float CapZ = VectorSubtract(RelZ, VectorMultiply(VectorSetFloat1(CapSign), S));
+			const VectorRegister4Float HalfB = VectorMultiplyAdd(CapZ, DirZ, HalfBXY);
+			const VectorRegister4Float C = VectorSubtract(VectorMultiplyAdd(CapZ, CapZ, RelXYSq), RSq);
+			const VectorRegister4Float Discriminant = VectorSubtract(VectorMultiply(HalfB, HalfB), C);
+			const VectorRegister4Float T = VectorSubtract(VectorNegate(HalfB), VectorSqrt(VectorMax(Discriminant, Zero)));
+
+			const VectorRegister4Float Valid = VectorBitwiseAnd(VectorCompareGE(Discriminant, Zero), VectorCompareGE(T, Zero));
+			Distance = VectorMin(Distance, VectorSelect(VectorCompareLE(C, Zero), Zero, VectorSelect(Valid, T, Miss)));
+		}
+
+		VectorStore(VectorSelect(RealLanes, Distance, Miss), &OutDistances[Base]);
+	}
+}
+
+int32 FVRiCCCapsuleSoA::IntersectRay(const FVector& Origin, const FVector3f& Direction, float MaxDistance, float& OutDistance) const
+{
+	TArray<float, TInlineAllocator<InlineCapsules>> Distances;
+	Distances.SetNumUninitialized(CenterX.Num());
+	IntersectRayAll(Origin, Direction, Distances);
+
+	int32 BestIndex = INDEX_NONE;
+	OutDistance = MaxDistance;
+	for (int32 Index = 0; Index < NumCapsules; ++Index)
+	{
+		if (Distances[Index] < OutDistance)
+		{
+			OutDistance = Distances[Index];
+			BestIndex = Index;
+		}
+	}
+	return BestIndex;
+}
+
+FVector FVRiCCCapsuleSoA::GetSurfaceNormal(int32 Index, const FVector& Location) const
+{
+	// from the closest point on the capsule axis towards the surface point
+	const double AxisZ = FMath::Clamp<double>(Location.Z, CenterZ[Index] - SegmentHalf[Index], CenterZ[Index] + SegmentHalf[Index]);
+	return (Location - FVector(CenterX[Index], CenterY[Index], AxisZ)).GetSafeNormal();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// VRiCCHitboxes
+
+namespace VRiCCHitboxes
+{
+	struct FBodyPartShape
+	{
+		EVRiCCBodyPart Part;
+		/** Offset from the capsule center, X forward, Y right, Z up */
+		FVector3f Offset;
+		float Radius;
+		float SegmentHalf;
+	};
+
+	/** Laid out for the 55x96 character capsule, scaled with the capsule half height */
+	static constexpr float LayoutHalfHeight = 96.f;
+	static const FBodyPartShape BodyLayout[NumBodyParts] =
+	{
+		{ EVRiCCBodyPart::Head,		FVector3f(0.f, 0.f, 78.f),		14.f, 0.f },
+		{ EVRiCCBodyPart::Torso,	FVector3f(0.f, 0.f, 30.f),		24.f, 22.f },
+		{ EVRiCCBodyPart::LeftArm,	FVector3f(0.f, -34.f, 26.f),	9.f, 24.f },
+		{ EVRiCCBodyPart::RightArm,	FVector3f(0.f, 34.f, 26.f),		9.f, 24.f },
+		{ EVRiCCBodyPart::Legs,		FVector3f(0.f, 0.f, -50.f),		22.f, 24.f },
+	};
+
+	void AddBodyParts(FVRiCCCapsuleSoA& Parts, const FVector3f& Center, float Radius, float HalfHeight, float Yaw)
+	{
+		const float Scale = HalfHeight / LayoutHalfHeight;
+		float SinYaw;
+		float CosYaw;
+		FMath::SinCos(&SinYaw, &CosYaw, FMath::DegreesToRadians(Yaw));
+
+		for (const FBodyPartShape& Shape : BodyLayout)
+		{
+			const FVector3f Offset = Shape.Offset * Scale;
+			const FVector3f Rotated(Offset.X * CosYaw - Offset.Y * SinYaw, Offset.X * SinYaw + Offset.Y * CosYaw, Offset.Z);
+			Parts.Add(Center + Rotated, Shape.Radius * Scale, Shape.SegmentHalf * Scale);
+		}
+	}
+
+	EVRiCCBodyPart GetBodyPart(int32 PartIndex)
+	{
+		return PartIndex >= 0 && PartIndex < NumBodyParts ? BodyLayout[PartIndex].Part : EVRiCCBodyPart::None;
+	}
+}
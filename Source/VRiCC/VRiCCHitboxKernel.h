@@ -0,0 +1,64 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Body part a character hitbox belongs to */
+enum class EVRiCCBodyPart : uint8
+{
+	None,
+	Head,
+	Torso,
+	LeftArm,
+	RightArm,
+	Legs,
+};
+
+/**
+ * Upright capsules in structure of arrays layout for the SIMD ray kernel, spheres are capsules without a segment.
+ * The arrays are padded to whole SIMD registers, padding lanes have a negative radius and never hit.
+ */
+struct VRICC_API FVRiCCCapsuleSoA
+{
+	static constexpr int32 Lanes = 4;
+
+	/** Capsules kept inline, enough for the body parts of one character or the bounds of a full server */
+	static constexpr int32 InlineCapsules = 64;
+
+	void Reset();
+
+	/** Adds a capsule around the vertical segment Center +- SegmentHalf and returns its index */
+	int32 Add(const FVector3f& Center, float Radius, float SegmentHalf);
+
+	int32 Num() const { return NumCapsules; }
+
+	/** Closest capsule the ray enters within MaxDistance, Direction must be normalized. INDEX_NONE on a miss */
+	int32 IntersectRay(const FVector& Origin, const FVector3f& Direction, float MaxDistance, float& OutDistance) const;
+
+	/** Entry distance of the ray into every capsule, UE_BIG_NUMBER for the ones it misses */
+	void IntersectRayAll(const FVector& Origin, const FVector3f& Direction, TArrayView<float> OutDistances) const;
+
+	/** Normal at a point on the surface of capsule Index */
+	FVector GetSurfaceNormal(int32 Index, const FVector& Location) const;
+
+	TArray<float, TInlineAllocator<InlineCapsules>> CenterX;
+	TArray<float, TInlineAllocator<InlineCapsules>> CenterY;
+	TArray<float, TInlineAllocator<InlineCapsules>> CenterZ;
+	TArray<float, TInlineAllocator<InlineCapsules>> Radius;
+	TArray<float, TInlineAllocator<InlineCapsules>> SegmentHalf;
+
+private:
+	int32 NumCapsules = 0;
+};
+
+namespace VRiCCHitboxes
+{
+	static constexpr int32 NumBodyParts = 5;
+
+	/** Adds head, torso, arms and legs of a character capsule, Yaw in degrees turns the arms with the character */
+	VRICC_API void AddBodyParts(FVRiCCCapsuleSoA& Parts, const FVector3f& Center, float Radius, float HalfHeight, float Yaw);
+
+	/** Body part of capsule PartIndex added by AddBodyParts */
+	VRICC_API EVRiCCBodyPart GetBodyPart(int32 PartIndex);
+}
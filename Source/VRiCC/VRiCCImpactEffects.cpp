@@ -0,0 +1,323 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCImpactEffects.h"
+#include "VRiCC.h"
+#include "VRiCCStats.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/DecalComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "NiagaraComponent.h"
+#include "NiagaraSystem.h"
+
+static TAutoConsoleVariable<int32> CVarImpactFXMaxEffects(
+	TEXT("VRiCC.ImpactFX.MaxEffects"),
+	32,
+	TEXT("Pooled impact particle components, the oldest one is reused once all exist."));
+
+static TAutoConsoleVariable<int32> CVarImpactFXMaxDecals(
+	TEXT("VRiCC.ImpactFX.MaxDecals"),
+	64,
+	TEXT("Pooled impact decals, the oldest one is moved once all exist."));
+
+static TAutoConsoleVariable<int32> CVarImpactFXEffectsPerFrame(
+	TEXT("VRiCC.ImpactFX.EffectsPerFrame"),
+	8,
+	TEXT("Impact particle effects started per frame, the most significant impacts of the frame go first."));
+
+static TAutoConsoleVariable<int32> CVarImpactFXDecalsPerFrame(
+	TEXT("VRiCC.ImpactFX.DecalsPerFrame"),
+	16,
+	TEXT("Impact decals placed per frame."));
+
+static TAutoConsoleVariable<float> CVarImpactFXMinSignificance(
+	TEXT("VRiCC.ImpactFX.MinSignificance"),
+	0.005f,
+	TEXT("Impacts smaller on screen than this fraction of the view get no particle effect."));
+
+static TAutoConsoleVariable<float> CVarImpactFXFullDetailSignificance(
+	TEXT("VRiCC.ImpactFX.FullDetailSignificance"),
+	0.03f,
+	TEXT("Impacts smaller on screen than this fraction of the view play the low detail effect."));
+
+static TAutoConsoleVariable<float> CVarImpactFXDecalDistance(
+	TEXT("VRiCC.ImpactFX.DecalDistance"),
+	4000.f,
+	TEXT("Impacts farther than this from the view leave no decal."));
+
+static TAutoConsoleVariable<float> CVarImpactFXDecalLifetime(
+	TEXT("VRiCC.ImpactFX.DecalLifetime"),
+	10.f,
+	TEXT("Seconds an impact decal stays visible unless its slot is reused first."));
+
+static FAutoConsoleCommandWithWorld GImpactFXStatsCommand(
+	TEXT("VRiCC.ImpactFX.Stats"),
+	TEXT("Prints how many impacts got a full or low detail effect, were culled or were over the frame budget."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCImpactEffectsSubsystem* ImpactEffects = World != nullptr ? World->GetSubsystem<UVRiCCImpactEffectsSubsystem>() : nullptr)
+		{
+			const FVRiCCImpactEffectStats& Stats = ImpactEffects->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("ImpactFX: total %llu, full %llu, low %llu, culled %llu, over budget %llu, decals %llu, last frame %d impacts in %.3fms"),
+				Stats.TotalImpacts, Stats.FullDetail, Stats.LowDetail, Stats.Culled, Stats.OverBudget, Stats.Decals, Stats.ImpactsLastFrame, Stats.ApplyMs);
+		}
+	}));
+
+bool UVRiCCImpactEffectsSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if VRICC_WITH_PRESENTATION
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+#else
+	return false;
+#endif
+}
+
+bool UVRiCCImpactEffectsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UVRiCCImpactEffectsSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// same point in the frame as the damage subsystem, every hit of the frame is known by then
+	PostActorTickHandle = FWorldDelegates::OnWorldPostActorTick.AddUObject(this, &UVRiCCImpactEffectsSubsystem::OnWorldPostActorTick);
+}
+
+void UVRiCCImpactEffectsSubsystem::Deinitialize()
+{
+	FWorldDelegates::OnWorldPostActorTick.Remove(PostActorTickHandle);
+
+	for (UNiagaraComponent* Component : EffectRing)
+	{
+		if (Component != nullptr)
+		{
+			Component->DestroyComponent();
+		}
+	}
+	for (UDecalComponent* Component : DecalRing)
+	{
+		if (Component != nullptr)
+		{
+			Component->DestroyComponent();
+		}
+	}
+	EffectRing.Reset();
+	DecalRing.Reset();
+	DecalTimes.Reset();
+	Pending.Reset();
+
+	Super::Deinitialize();
+}
+
+void UVRiCCImpactEffectsSubsystem::QueueImpact(const FVRiCCImpactEffectSet& Effects, const FVector& Location, const FVector& Normal, bool bAllowDecal)
+{
+	// a PIE dedicated server still creates the subsystem, nobody sees its impacts
+	if (Effects.IsEmpty() || !VRiCC::IsPresentationEnabled(this))
+	{
+		return;
+	}
+
+	FImpact& Impact = Pending.AddDefaulted_GetRef();
+	Impact.Effects = Effects;
+	Impact.Location = Location;
+	Impact.Normal = Normal;
+	Impact.Significance = 0.f;
+	Impact.bAllowDecal = bAllowDecal;
+}
+
+void UVRiCCImpactEffectsSubsystem::OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds)
+{
+	if (World == GetWorld())
+	{
+		ExpireDecals(World->GetTimeSeconds());
+		ApplyPending();
+	}
+}
+
+void UVRiCCImpactEffectsSubsystem::ApplyPending()
+{
+	if (Pending.Num() == 0)
+	{
+		return;
+	}
+
+	VRICC_SCOPE_CYCLE(ImpactEffects);
+	const double StartSeconds = FPlatformTime::Seconds();
+	Stats.ImpactsLastFrame = Pending.Num();
+	Stats.TotalImpacts += Pending.Num();
+
+	// no local view, nothing to show
+	const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController();
+	const APlayerCameraManager* CameraManager = PlayerController != nullptr ? PlayerController->PlayerCameraManager.Get() : nullptr;
+	if (CameraManager == nullptr)
+	{
+		Stats.Culled += Pending.Num();
+		Pending.Reset();
+		return;
+	}
+
+	const FVector ViewLocation = CameraManager->GetCameraLocation();
+	const FVector ViewDirection = CameraManager->GetCameraRotation().Vector();
+	const float HalfFOV = FMath::DegreesToRadians(CameraManager->GetFOVAngle() * 0.5f);
+	const float TanHalfFOV = FMath::Tan(HalfFOV);
+
+	// a little wider than the view so effects just outside the edge are there when the camera turns
+	const float CosVisibleCone = FMath::Cos(FMath::Min(HalfFOV + FMath::DegreesToRadians(10.f), UE_HALF_PI));
+
+	// significance is roughly the fraction of the view width the effect covers
+	for (FImpact& Impact : Pending)
+	{
+		const FVector ToImpact = Impact.Location - ViewLocation;
+		const float Distance = ToImpact.Size();
+		if (Distance <= Impact.Effects.EffectRadius)
+		{
+			Impact.Significance = 1.f;
+		}
+		else if (FVector::DotProduct(ToImpact, ViewDirection) >= CosVisibleCone * Distance)
+		{
+			Impact.Significance = Impact.Effects.EffectRadius / (Distance * TanHalfFOV);
+		}
+	}
+
+	const int32 EffectsPerFrame = CVarImpactFXEffectsPerFrame.GetValueOnGameThread();
+	const int32 DecalsPerFrame = CVarImpactFXDecalsPerFrame.GetValueOnGameThread();
+	if (Pending.Num() > FMath::Min(EffectsPerFrame, DecalsPerFrame))
+	{
+		Pending.Sort([](const FImpact& A, const FImpact& B) { return A.Significance > B.Significance; });
+	}
+
+	const float MinSignificance = CVarImpactFXMinSignificance.GetValueOnGameThread();
+	const float FullDetailSignificance = CVarImpactFXFullDetailSignificance.GetValueOnGameThread();
+	const double DecalDistanceSquared = FMath::Square(CVarImpactFXDecalDistance.GetValueOnGameThread());
+
+	int32 NumEffects = 0;
+	int32 NumDecals = 0;
+	for (const FImpact& Impact : Pending)
+	{
+		UNiagaraSystem* System = nullptr;
+		if (Impact.Significance >= MinSignificance)
+		{
+			const bool bFullDetail = Impact.Significance >= FullDetailSignificance && Impact.Effects.Effect != nullptr;
+			System = bFullDetail ? Impact.Effects.Effect.Get() : Impact.Effects.LowDetailEffect.Get();
+		}
+
+		if (System == nullptr)
+		{
+			Stats.Culled++;
+		}
+		else if (NumEffects >= EffectsPerFrame)
+		{
+			Stats.OverBudget++;
+		}
+		else
+		{
+			PlayEffect(System, Impact.Location, Impact.Normal);
+			NumEffects++;
+			if (System == Impact.Effects.Effect)
+			{
+				Stats.FullDetail++;
+			}
+			else
+			{
+				Stats.LowDetail++;
+			}
+		}
+
+		// decals stay behind, so they are placed off screen too as long as the view is close enough
+		if (Impact.bAllowDecal && Impact.Effects.DecalMaterial != nullptr && NumDecals < DecalsPerFrame
+			&& FVector::DistSquared(Impact.Location, ViewLocation) < DecalDistanceSquared)
+		{
+			PlaceDecal(Impact);
+			NumDecals++;
+			Stats.Decals++;
+		}
+	}
+
+	// keep the allocation for the next frame
+	Pending.Reset();
+
+	Stats.ApplyMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+}
+
+void UVRiCCImpactEffectsSubsystem::PlayEffect(UNiagaraSystem* System, const FVector& Location, const FVector& Normal)
+{
+	UNiagaraComponent* Component = nullptr;
+	if (EffectRing.Num() < FMath::Max(CVarImpactFXMaxEffects.GetValueOnGameThread(), 1))
+	{
+		Component = NewObject<UNiagaraComponent>(GetWorld());
+		Component->SetAutoActivate(false);
+		Component->SetAutoDestroy(false);
+		Component->RegisterComponentWithWorld(GetWorld());
+		EffectRing.Add(Component);
+	}
+	else
+	{
+		Component = EffectRing[NextEffect];
+		NextEffect = (NextEffect + 1) % EffectRing.Num();
+	}
+
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	if (Component->GetAsset() != System)
+	{
+		Component->SetAsset(System);
+	}
+	Component->SetWorldLocationAndRotation(Location, Normal.Rotation());
+	Component->Activate(true);
+}
+
+void UVRiCCImpactEffectsSubsystem::PlaceDecal(const FImpact& Impact)
+{
+	UDecalComponent* Decal = nullptr;
+	int32 Slot = INDEX_NONE;
+	if (DecalRing.Num() < FMath::Max(CVarImpactFXMaxDecals.GetValueOnGameThread(), 1))
+	{
+		Decal = NewObject<UDecalComponent>(GetWorld());
+		Decal->RegisterComponentWithWorld(GetWorld());
+		Slot = DecalRing.Add(Decal);
+		DecalTimes.Add(0.0);
+	}
+	else
+	{
+		Slot = NextDecal;
+		Decal = DecalRing[Slot];
+		NextDecal = (NextDecal + 1) % DecalRing.Num();
+	}
+
+	if (Decal == nullptr)
+	{
+		return;
+	}
+
+	// projected into the surface, with a random roll so a burst does not stamp the same pattern
+	FRotator Rotation = (-Impact.Normal).Rotation();
+	Rotation.Roll = FMath::FRandRange(-180.f, 180.f);
+
+	Decal->DecalSize = Impact.Effects.DecalSize;
+	Decal->SetDecalMaterial(Impact.Effects.DecalMaterial);
+	Decal->SetWorldLocationAndRotation(Impact.Location, Rotation);
+	Decal->SetVisibility(true);
+	DecalTimes[Slot] = GetWorld()->GetTimeSeconds();
+}
+
+void UVRiCCImpactEffectsSubsystem::ExpireDecals(double Now)
+{
+	const double Lifetime = CVarImpactFXDecalLifetime.GetValueOnGameThread();
+	for (int32 Slot = 0; Slot < DecalRing.Num(); ++Slot)
+	{
+		if (DecalTimes[Slot] > 0.0 && Now - DecalTimes[Slot] > Lifetime)
+		{
+			DecalTimes[Slot] = 0.0;
+			if (UDecalComponent* Decal = DecalRing[Slot])
+			{
+				Decal->SetVisibility(false);
+			}
+		}
+	}
+}
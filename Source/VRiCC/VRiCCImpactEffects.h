@@ -0,0 +1,116 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCImpactEffects.generated.h"
+
+class UDecalComponent;
+class UMaterialInterface;
+class UNiagaraComponent;
+class UNiagaraSystem;
+
+/** What a bullet or projectile leaves behind where it hits */
+USTRUCT(BlueprintType)
+struct FVRiCCImpactEffectSet
+{
+	GENERATED_BODY()
+
+	/** Played for impacts that are close or large on screen */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Impact)
+	TObjectPtr<UNiagaraSystem> Effect = nullptr;
+
+	/** Cheaper stand in for small or distant impacts, nothing is played for them if unset */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Impact)
+	TObjectPtr<UNiagaraSystem> LowDetailEffect = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Impact)
+	TObjectPtr<UMaterialInterface> DecalMaterial = nullptr;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Impact)
+	FVector DecalSize = FVector(4.0, 8.0, 8.0);
+
+	/** Rough size of the effect, the screen significance of an impact is this radius over its view distance */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Impact, meta = (ClampMin = "1"))
+	float EffectRadius = 30.f;
+
+	bool IsEmpty() const { return Effect == nullptr && LowDetailEffect == nullptr && DecalMaterial == nullptr; }
+};
+
+/** Counters of the impact effects, "last frame" values are overwritten every frame impacts were applied */
+struct FVRiCCImpactEffectStats
+{
+	int32 ImpactsLastFrame = 0;
+	uint64 TotalImpacts = 0;
+	uint64 FullDetail = 0;
+	uint64 LowDetail = 0;
+	/** Off screen, too far or too small for an effect */
+	uint64 Culled = 0;
+	/** Significant enough but past the per frame budget */
+	uint64 OverBudget = 0;
+	uint64 Decals = 0;
+	double ApplyMs = 0.0;
+};
+
+/**
+ * Impact particles and decals for every hit of a frame, applied once the actors and tickables are done.
+ * Components come from fixed size rings that overwrite their oldest entry, and only the most significant
+ * impacts of a frame get a particle effect, so a firefight costs the same memory and at most a fixed number
+ * of activations per frame however many bullets land.
+ * Not created on dedicated servers and compiled out of the server target.
+ */
+UCLASS()
+class VRICC_API UVRiCCImpactEffectsSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	/** Queues an impact, bAllowDecal is false for surfaces that move such as characters */
+	void QueueImpact(const FVRiCCImpactEffectSet& Effects, const FVector& Location, const FVector& Normal, bool bAllowDecal = true);
+
+	const FVRiCCImpactEffectStats& GetStats() const { return Stats; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FImpact
+	{
+		FVRiCCImpactEffectSet Effects;
+		FVector Location;
+		FVector Normal;
+		float Significance;
+		bool bAllowDecal;
+	};
+
+	void OnWorldPostActorTick(UWorld* World, ELevelTick TickType, float DeltaSeconds);
+
+	/** Rates the queued impacts against the view and spends the frame's budget on the most significant */
+	void ApplyPending();
+
+	void PlayEffect(UNiagaraSystem* System, const FVector& Location, const FVector& Normal);
+	void PlaceDecal(const FImpact& Impact);
+
+	/** Hides decals older than VRiCC.ImpactFX.DecalLifetime */
+	void ExpireDecals(double Now);
+
+	TArray<FImpact> Pending;
+
+	/** Rings of pooled components, grown up to their cap and then reused oldest first */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UNiagaraComponent>> EffectRing;
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UDecalComponent>> DecalRing;
+	TArray<double> DecalTimes;
+	int32 NextEffect = 0;
+	int32 NextDecal = 0;
+
+	FDelegateHandle PostActorTickHandle;
+
+	FVRiCCImpactEffectStats Stats;
+};
@@ -0,0 +1,570 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCInputRecorder.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCPlayerController.h"
+#include "TP_WeaponComponent.h"
+#include "EnhancedInputComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "InputActionValue.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+static TAutoConsoleVariable<float> CVarInputReplayHz(
+	TEXT("VRiCC.Input.ReplayHz"),
+	60.f,
+	TEXT("Fixed timestep of replays, stored in recordings made without -benchmark -fps=N. -VRiCCReplayHz=N overrides it for one replay."));
+
+static TAutoConsoleVariable<int32> CVarInputCheckpointInterval(
+	TEXT("VRiCC.Input.CheckpointInterval"),
+	30,
+	TEXT("Frames between the character states a recording stores for replays to compare against."));
+
+static TAutoConsoleVariable<float> CVarInputDivergenceTolerance(
+	TEXT("VRiCC.Input.DivergenceTolerance"),
+	1.f,
+	TEXT("Centimeters a replayed character may be off its recorded location before the replay counts as diverged."));
+
+namespace VRiCCInputRecorder
+{
+	static UVRiCCInputRecorderComponent* GetRecorder(UWorld* World)
+	{
+		AVRiCCPlayerController* PlayerController = World != nullptr ? Cast<AVRiCCPlayerController>(World->GetFirstPlayerController()) : nullptr;
+		return PlayerController != nullptr ? PlayerController->GetInputRecorder() : nullptr;
+	}
+
+	/** The actions and trigger events the character and weapon bindings react to */
+	static const TPair<EVRiCCRecordedAction, ETriggerEvent> BoundEvents[] =
+	{
+		{ EVRiCCRecordedAction::Jump, ETriggerEvent::Started },
+		{ EVRiCCRecordedAction::Jump, ETriggerEvent::Completed },
+		{ EVRiCCRecordedAction::Move, ETriggerEvent::Triggered },
+		{ EVRiCCRecordedAction::Look, ETriggerEvent::Triggered },
+		{ EVRiCCRecordedAction::Fire, ETriggerEvent::Started },
+		{ EVRiCCRecordedAction::Fire, ETriggerEvent::Triggered },
+		{ EVRiCCRecordedAction::Fire, ETriggerEvent::Completed },
+		{ EVRiCCRecordedAction::Reload, ETriggerEvent::Triggered },
+		{ EVRiCCRecordedAction::FireMode, ETriggerEvent::Triggered },
+	};
+}
+
+static FAutoConsoleCommandWithWorldAndArgs GInputRecordCommand(
+	TEXT("VRiCC.Input.Record"),
+	TEXT("Starts recording the local player's input. Usage: VRiCC.Input.Record [Path], defaults to Saved/InputRecordings/."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UVRiCCInputRecorderComponent* Recorder = VRiCCInputRecorder::GetRecorder(World))
+		{
+			Recorder->StartRecording(Args.Num() > 0 ? Args[0] : FString());
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GInputStopCommand(
+	TEXT("VRiCC.Input.Stop"),
+	TEXT("Stops and saves the input recording, or stops the replay."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UVRiCCInputRecorderComponent* Recorder = VRiCCInputRecorder::GetRecorder(World))
+		{
+			if (Recorder->IsReplaying())
+			{
+				Recorder->StopReplay();
+			}
+			else
+			{
+				Recorder->StopRecording();
+			}
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GInputReplayCommand(
+	TEXT("VRiCC.Input.Replay"),
+	TEXT("Replays an input recording on the local player. Usage: VRiCC.Input.Replay Path"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UVRiCCInputRecorderComponent* Recorder = VRiCCInputRecorder::GetRecorder(World);
+		if (Recorder != nullptr && Args.Num() > 0)
+		{
+			Recorder->StartReplay(Args[0]);
+		}
+	}));
+
+FArchive& operator<<(FArchive& Ar, FVRiCCInputEvent& Event)
+{
+	uint8 Action = uint8(Event.Action);
+	uint8 Trigger = uint8(Event.Trigger);
+	Ar << Event.Frame << Action << Trigger << Event.Value;
+	Event.Action = EVRiCCRecordedAction(Action);
+	Event.Trigger = ETriggerEvent(Trigger);
+	return Ar;
+}
+
+FArchive& operator<<(FArchive& Ar, FVRiCCInputCheckpoint& Checkpoint)
+{
+	Ar << Checkpoint.Frame << Checkpoint.Location << Checkpoint.Pitch << Checkpoint.Yaw;
+	Ar << Checkpoint.ShotsLeft << Checkpoint.AmmoRacks << Checkpoint.ShotsFired;
+	return Ar;
+}
+
+UVRiCCInputRecorderComponent::UVRiCCInputRecorderComponent()
+{
+	// driven by the player controller's input, not by a tick of its own
+	PrimaryComponentTick.bCanEverTick = false;
+}
+
+void UVRiCCInputRecorderComponent::ConfigureFromCommandLine()
+{
+	FString Path;
+	if (FParse::Value(FCommandLine::Get(), TEXT("VRiCCReplayInput="), Path))
+	{
+		StartReplay(Path, true);
+	}
+	else if (FParse::Param(FCommandLine::Get(), TEXT("VRiCCRecordInput")))
+	{
+		FParse::Value(FCommandLine::Get(), TEXT("VRiCCRecordInput="), Path);
+		StartRecording(Path);
+	}
+}
+
+void UVRiCCInputRecorderComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// a recording still running when the game quits is saved, a replay is reported
+	if (bRecording)
+	{
+		StopRecording();
+	}
+	if (bReplaying)
+	{
+		StopReplay();
+	}
+	UnbindActions();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AVRiCCCharacter* UVRiCCInputRecorderComponent::GetCharacter() const
+{
+	const AController* Controller = Cast<AController>(GetOwner());
+	return Controller != nullptr ? Cast<AVRiCCCharacter>(Controller->GetPawn()) : nullptr;
+}
+
+void UVRiCCInputRecorderComponent::StartRecording(const FString& Path)
+{
+	if (bReplaying)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Input: cannot record during a replay"));
+		return;
+	}
+
+	RecordingPath = !Path.IsEmpty() ? Path : FPaths::ProjectSavedDir() / TEXT("InputRecordings") / FString::Printf(TEXT("Input-%s.vrir"), *FDateTime::Now().ToString());
+
+	// a recording made at a fixed timestep replays exactly, any other one replays at VRiCC.Input.ReplayHz
+	FixedHz = FApp::UseFixedTimeStep() && FApp::GetFixedDeltaTime() > 0.0 ? float(1.0 / FApp::GetFixedDeltaTime()) : CVarInputReplayHz.GetValueOnGameThread();
+
+	FrameDeltas.Reset();
+	Events.Reset();
+	Checkpoints.Reset();
+	Frame = INDEX_NONE;
+	bRecording = true;
+
+	UE_LOG(LogTemp, Display, TEXT("Input: recording to %s"), *RecordingPath);
+}
+
+bool UVRiCCInputRecorderComponent::StopRecording()
+{
+	if (!bRecording)
+	{
+		return false;
+	}
+	bRecording = false;
+	UnbindActions();
+
+	if (!Save(RecordingPath))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Input: could not write %s"), *RecordingPath);
+		return false;
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Input: wrote %d frames, %d events, %d checkpoints to %s"), FrameDeltas.Num(), Events.Num(), Checkpoints.Num(), *RecordingPath);
+	return true;
+}
+
+bool UVRiCCInputRecorderComponent::StartReplay(const FString& Path, bool bInExitWhenDone)
+{
+	if (bRecording || bReplaying)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Input: already recording or replaying"));
+		return false;
+	}
+	if (!Load(Path))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Input: could not read the recording %s"), *Path);
+		return false;
+	}
+
+	FParse::Value(FCommandLine::Get(), TEXT("VRiCCReplayHz="), FixedHz);
+
+	// every frame advances the game by the same step, however long it took to run
+	bPreviousFixedTimeStep = FApp::UseFixedTimeStep();
+	PreviousFixedDeltaTime = FApp::GetFixedDeltaTime();
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(1.0 / FMath::Max(FixedHz, 1.f));
+
+	Frame = INDEX_NONE;
+	NextEvent = 0;
+	NextCheckpoint = 0;
+	ReplayFrameMs.Reset(FrameDeltas.Num());
+	NumDiverged = 0;
+	FirstDivergedFrame = INDEX_NONE;
+	bExitWhenDone = bInExitWhenDone;
+	bReplaying = true;
+
+	UE_LOG(LogTemp, Display, TEXT("Input: replaying %d frames of %s at %.0fHz"), FrameDeltas.Num(), *Path, FixedHz);
+	return true;
+}
+
+void UVRiCCInputRecorderComponent::StopReplay()
+{
+	if (!bReplaying)
+	{
+		return;
+	}
+	bReplaying = false;
+
+	FApp::SetUseFixedTimeStep(bPreviousFixedTimeStep);
+	FApp::SetFixedDeltaTime(PreviousFixedDeltaTime);
+
+	// release whatever the recording still held
+	if (AVRiCCCharacter* Character = GetCharacter())
+	{
+		if (UTP_WeaponComponent* Weapon = Character->GetWeapon())
+		{
+			Weapon->FireStop();
+		}
+		Character->StopJumping();
+	}
+
+	FinishReplay();
+}
+
+void UVRiCCInputRecorderComponent::BeginInputFrame(float DeltaTime)
+{
+	if (!bRecording && !bReplaying)
+	{
+		return;
+	}
+
+	AVRiCCCharacter* Character = GetCharacter();
+	if (Character == nullptr)
+	{
+		return;
+	}
+
+	// both start with the first frame the character is possessed, a replay from where the recording started
+	if (Frame == INDEX_NONE)
+	{
+		if (bRecording)
+		{
+			StartLocation = Character->GetActorLocation();
+			StartRotation = Character->GetControlRotation();
+		}
+		else
+		{
+			Character->SetActorLocation(StartLocation, false, nullptr, ETeleportType::ResetPhysics);
+			Character->GetController()->SetControlRotation(StartRotation);
+			LastFrameSeconds = FPlatformTime::Seconds();
+		}
+	}
+	Frame++;
+
+	const int32 CheckpointInterval = FMath::Max(CVarInputCheckpointInterval.GetValueOnGameThread(), 1);
+	if (bRecording)
+	{
+		BindActions(Character);
+		FrameDeltas.Add(DeltaTime);
+		if (Frame % CheckpointInterval == 0)
+		{
+			Checkpoints.Add(MakeCheckpoint(Character));
+		}
+		return;
+	}
+
+	if (Frame >= FrameDeltas.Num())
+	{
+		StopReplay();
+		return;
+	}
+
+	// the frame before, from this input to the next
+	const double NowSeconds = FPlatformTime::Seconds();
+	if (Frame > 0)
+	{
+		ReplayFrameMs.Add(float((NowSeconds - LastFrameSeconds) * 1000.0));
+	}
+	LastFrameSeconds = NowSeconds;
+
+	if (NextCheckpoint < Checkpoints.Num() && Checkpoints[NextCheckpoint].Frame == uint32(Frame))
+	{
+		const FVRiCCInputCheckpoint& Recorded = Checkpoints[NextCheckpoint++];
+		const FVRiCCInputCheckpoint Replayed = MakeCheckpoint(Character);
+		const float Tolerance = CVarInputDivergenceTolerance.GetValueOnGameThread();
+		const bool bDiverged = FVector3f::DistSquared(Recorded.Location, Replayed.Location) > FMath::Square(Tolerance)
+			|| Recorded.ShotsLeft != Replayed.ShotsLeft || Recorded.AmmoRacks != Replayed.AmmoRacks || Recorded.ShotsFired != Replayed.ShotsFired;
+		if (bDiverged)
+		{
+			if (NumDiverged == 0)
+			{
+				FirstDivergedFrame = Frame;
+				UE_LOG(LogTemp, Warning, TEXT("Input: replay diverged at frame %d, %.1fcm off, shots %u against %u recorded"),
+					Frame, FVector3f::Dist(Recorded.Location, Replayed.Location), Replayed.ShotsFired, Recorded.ShotsFired);
+			}
+			NumDiverged++;
+		}
+	}
+
+	while (NextEvent < Events.Num() && Events[NextEvent].Frame == uint32(Frame))
+	{
+		Dispatch(Character, Events[NextEvent++]);
+	}
+}
+
+void UVRiCCInputRecorderComponent::BindActions(AVRiCCCharacter* Character)
+{
+	APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	UEnhancedInputComponent* InputComponent = PlayerController != nullptr ? Cast<UEnhancedInputComponent>(PlayerController->InputComponent) : nullptr;
+	UTP_WeaponComponent* Weapon = Character->GetWeapon();
+	if (InputComponent == nullptr || (BoundInputComponent == InputComponent && BoundWeapon == Weapon))
+	{
+		return;
+	}
+	if (BoundInputComponent != InputComponent)
+	{
+		UnbindActions();
+	}
+	BoundInputComponent = InputComponent;
+	BoundWeapon = Weapon;
+
+	// the same actions the character and weapon bind, the weapon's only once one is attached
+	const UInputAction* Actions[] =
+	{
+		Character->JumpAction,
+		Character->MoveAction,
+		Character->LookAction,
+		Weapon != nullptr ? Weapon->FireAction : nullptr,
+		Weapon != nullptr ? Weapon->ReloadAction : nullptr,
+		Weapon != nullptr ? Weapon->FireModeAction : nullptr,
+	};
+
+	for (uint8 Kind = 0; Kind < UE_ARRAY_COUNT(Actions); ++Kind)
+	{
+		const TPair<const UInputAction*, EVRiCCRecordedAction> BoundAction(Actions[Kind], EVRiCCRecordedAction(Kind));
+		if (BoundAction.Key == nullptr || BoundActions.Contains(BoundAction))
+		{
+			continue;
+		}
+		BoundActions.Add(BoundAction);
+
+		for (const TPair<EVRiCCRecordedAction, ETriggerEvent>& BoundEvent : VRiCCInputRecorder::BoundEvents)
+		{
+			if (BoundEvent.Key == BoundAction.Value)
+			{
+				BindingHandles.Add(InputComponent->BindAction(BoundAction.Key, BoundEvent.Value, this, &UVRiCCInputRecorderComponent::OnInputAction).GetHandle());
+			}
+		}
+	}
+}
+
+void UVRiCCInputRecorderComponent::UnbindActions()
+{
+	if (UEnhancedInputComponent* InputComponent = BoundInputComponent.Get())
+	{
+		for (uint32 Handle : BindingHandles)
+		{
+			InputComponent->RemoveBindingByHandle(Handle);
+		}
+	}
+	BindingHandles.Reset();
+	BoundActions.Reset();
+	BoundInputComponent.Reset();
+	BoundWeapon.Reset();
+}
+
+void UVRiCCInputRecorderComponent::OnInputAction(const FInputActionInstance& Instance)
+{
+	if (!bRecording || Frame == INDEX_NONE)
+	{
+		return;
+	}
+
+	for (const TPair<const UInputAction*, EVRiCCRecordedAction>& BoundAction : BoundActions)
+	{
+		if (BoundAction.Key == Instance.GetSourceAction())
+		{
+			FVRiCCInputEvent& Event = Events.AddDefaulted_GetRef();
+			Event.Frame = uint32(Frame);
+			Event.Action = BoundAction.Value;
+			Event.Trigger = Instance.GetTriggerEvent();
+			Event.Value = FVector2f(Instance.GetValue().Get<FVector2D>());
+			return;
+		}
+	}
+}
+
+FVRiCCInputCheckpoint UVRiCCInputRecorderComponent::MakeCheckpoint(AVRiCCCharacter* Character) const
+{
+	const UTP_WeaponComponent* Weapon = Character->GetWeapon();
+	const FRotator ControlRotation = Character->GetControlRotation();
+
+	FVRiCCInputCheckpoint Checkpoint;
+	Checkpoint.Frame = uint32(Frame);
+	Checkpoint.Location = FVector3f(Character->GetActorLocation());
+	Checkpoint.Pitch = float(ControlRotation.Pitch);
+	Checkpoint.Yaw = float(ControlRotation.Yaw);
+	Checkpoint.ShotsLeft = Character->VRiCC_ShotsLeft;
+	Checkpoint.AmmoRacks = Character->VRiCC_AmmoRacks;
+	Checkpoint.ShotsFired = Weapon != nullptr ? Weapon->GetShotsFired() : 0;
+	return Checkpoint;
+}
+
+void UVRiCCInputRecorderComponent::Dispatch(AVRiCCCharacter* Character, const FVRiCCInputEvent& Event) const
+{
+	UTP_WeaponComponent* Weapon = Character->GetWeapon();
+	const FVector2D Value(Event.Value);
+
+	switch (Event.Action)
+	{
+	case EVRiCCRecordedAction::Jump:
+		if (Event.Trigger == ETriggerEvent::Started)
+		{
+			Character->Jump();
+		}
+		else
+		{
+			Character->StopJumping();
+		}
+		break;
+
+	case EVRiCCRecordedAction::Move:
+		Character->Move(FInputActionValue(Value));
+		break;
+
+	case EVRiCCRecordedAction::Look:
+		Character->Look(FInputActionValue(Value));
+		break;
+
+	case EVRiCCRecordedAction::Fire:
+		if (Weapon == nullptr)
+		{
+			break;
+		}
+		if (Event.Trigger == ETriggerEvent::Started)
+		{
+			Weapon->AutoFire();
+		}
+		else if (Event.Trigger == ETriggerEvent::Triggered)
+		{
+			Weapon->Fire();
+		}
+		else
+		{
+			Weapon->FireStop();
+		}
+		break;
+
+	case EVRiCCRecordedAction::Reload:
+		if (Weapon != nullptr)
+		{
+			Weapon->Reload();
+		}
+		break;
+
+	case EVRiCCRecordedAction::FireMode:
+		if (Weapon != nullptr)
+		{
+			Weapon->ChangeFireMode();
+		}
+		break;
+	}
+}
+
+void UVRiCCInputRecorderComponent::FinishReplay()
+{
+	TArray<float> SortedMs = ReplayFrameMs;
+	SortedMs.Sort();
+
+	double SumMs = 0.0;
+	int32 WorstFrame = INDEX_NONE;
+	for (int32 Index = 0; Index < ReplayFrameMs.Num(); ++Index)
+	{
+		SumMs += ReplayFrameMs[Index];
+		if (WorstFrame == INDEX_NONE || ReplayFrameMs[Index] > ReplayFrameMs[WorstFrame])
+		{
+			WorstFrame = Index;
+		}
+	}
+
+	if (SortedMs.Num() > 0)
+	{
+		// ReplayFrameMs[i] is the frame that started at input frame i, the recorded time locates the hitch in the capture
+		double RecordedSeconds = 0.0;
+		for (int32 Index = 0; Index < WorstFrame; ++Index)
+		{
+			RecordedSeconds += FrameDeltas[Index];
+		}
+		UE_LOG(LogTemp, Display, TEXT("Input: replayed %d frames, avg %.3fms, p95 %.3fms, worst %.3fms at frame %d (%.2fs into the recording)"),
+			SortedMs.Num(), SumMs / SortedMs.Num(), SortedMs[FMath::Min(int32(SortedMs.Num() * 0.95f), SortedMs.Num() - 1)],
+			ReplayFrameMs[WorstFrame], WorstFrame, RecordedSeconds);
+	}
+
+	if (NumDiverged > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Input: %d of %d checkpoints diverged, first at frame %d"), NumDiverged, NextCheckpoint, FirstDivergedFrame);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Display, TEXT("Input: replay matched all %d checkpoints"), NextCheckpoint);
+	}
+
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+bool UVRiCCInputRecorderComponent::Save(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = FileMagic;
+	uint32 Version = FileVersion;
+	Writer << Magic << Version << FixedHz << StartLocation << StartRotation << FrameDeltas << Events << Checkpoints;
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
+
+bool UVRiCCInputRecorderComponent::Load(const FString& Path)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Path))
+	{
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != FileMagic || Version != FileVersion)
+	{
+		return false;
+	}
+
+	Reader << FixedHz << StartLocation << StartRotation << FrameDeltas << Events << Checkpoints;
+	return !Reader.IsError();
+}
@@ -0,0 +1,143 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "InputTriggers.h"
+#include "VRiCCInputRecorder.generated.h"
+
+class AVRiCCCharacter;
+class UEnhancedInputComponent;
+class UInputAction;
+class UTP_WeaponComponent;
+struct FInputActionInstance;
+
+/** Input actions bound by AVRiCCCharacter::SetupPlayerInputComponent and UTP_WeaponComponent::AttachWeapon */
+enum class EVRiCCRecordedAction : uint8
+{
+	Jump,
+	Move,
+	Look,
+	Fire,
+	Reload,
+	FireMode,
+};
+
+/** One delivered input action, Frame counts from the start of the recording */
+struct FVRiCCInputEvent
+{
+	uint32 Frame = 0;
+	EVRiCCRecordedAction Action = EVRiCCRecordedAction::Move;
+	ETriggerEvent Trigger = ETriggerEvent::Triggered;
+	FVector2f Value = FVector2f::ZeroVector;
+
+	friend FArchive& operator<<(FArchive& Ar, FVRiCCInputEvent& Event);
+};
+
+/** State of the character at the start of Frame, replays compare against it to find where they diverge */
+struct FVRiCCInputCheckpoint
+{
+	uint32 Frame = 0;
+	FVector3f Location = FVector3f::ZeroVector;
+	float Pitch = 0.f;
+	float Yaw = 0.f;
+	int32 ShotsLeft = 0;
+	int32 AmmoRacks = 0;
+	uint32 ShotsFired = 0;
+
+	friend FArchive& operator<<(FArchive& Ar, FVRiCCInputCheckpoint& Checkpoint);
+};
+
+/**
+ * Records the input actions of the local player with the frame they arrived in, and plays a recording back
+ * through the same calls the bindings make, one recorded frame per fixed timestep. A captured firefight
+ * replays identically on a -nullrhi client, which makes it a repeatable benchmark and a repro for hitches.
+ * Started with -VRiCCRecordInput[=Path] or -VRiCCReplayInput=Path, or the VRiCC.Input.* console commands.
+ * AVRiCCPlayerController calls BeginInputFrame before it processes its input each frame.
+ */
+UCLASS(ClassGroup=(Custom))
+class VRICC_API UVRiCCInputRecorderComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	/** File layout: Magic, Version, FixedHz, start pose, per frame deltas, events, checkpoints */
+	static constexpr uint32 FileMagic = 0x52495256; // "VRIR"
+	static constexpr uint32 FileVersion = 1;
+
+	UVRiCCInputRecorderComponent();
+
+	/** Reads -VRiCCRecordInput[=Path] and -VRiCCReplayInput=Path, a command line replay quits when it ends */
+	void ConfigureFromCommandLine();
+
+	/** Records until StopRecording, Path defaults to Saved/InputRecordings/ */
+	void StartRecording(const FString& Path = FString());
+	/** Writes the recording, returns false if there was none or it could not be written */
+	bool StopRecording();
+
+	/** Loads Path and replays it at its fixed timestep, bExitWhenDone quits after the report */
+	bool StartReplay(const FString& Path, bool bExitWhenDone = false);
+	void StopReplay();
+
+	bool IsRecording() const { return bRecording; }
+	bool IsReplaying() const { return bReplaying; }
+
+	/** Stamps the frame the input processed next belongs to, and feeds a replay's actions of that frame */
+	void BeginInputFrame(float DeltaTime);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	AVRiCCCharacter* GetCharacter() const;
+
+	/** Binds the recorded actions of Character and its weapon that are not bound yet */
+	void BindActions(AVRiCCCharacter* Character);
+	void UnbindActions();
+	void OnInputAction(const FInputActionInstance& Instance);
+
+	FVRiCCInputCheckpoint MakeCheckpoint(AVRiCCCharacter* Character) const;
+
+	/** Makes the call the input binding of Event makes */
+	void Dispatch(AVRiCCCharacter* Character, const FVRiCCInputEvent& Event) const;
+
+	void FinishReplay();
+
+	bool Save(const FString& Path);
+	bool Load(const FString& Path);
+
+	/** Recording or replay */
+	float FixedHz = 60.f;
+	FVector StartLocation = FVector::ZeroVector;
+	FRotator StartRotation = FRotator::ZeroRotator;
+	TArray<float> FrameDeltas;
+	TArray<FVRiCCInputEvent> Events;
+	TArray<FVRiCCInputCheckpoint> Checkpoints;
+
+	FString RecordingPath;
+	bool bRecording = false;
+	bool bReplaying = false;
+	bool bExitWhenDone = false;
+
+	/** Frame the input currently delivered belongs to, INDEX_NONE until the character is there */
+	int32 Frame = INDEX_NONE;
+
+	/** Replay cursors into Events and Checkpoints */
+	int32 NextEvent = 0;
+	int32 NextCheckpoint = 0;
+
+	/** Replay measurements, wall clock milliseconds between input frames */
+	TArray<float> ReplayFrameMs;
+	double LastFrameSeconds = 0.0;
+	int32 NumDiverged = 0;
+	int32 FirstDivergedFrame = INDEX_NONE;
+	bool bPreviousFixedTimeStep = false;
+	double PreviousFixedDeltaTime = 0.0;
+
+	/** Live bindings of the recorder on the controller's input component */
+	TArray<uint32> BindingHandles;
+	TArray<TPair<const UInputAction*, EVRiCCRecordedAction>> BoundActions;
+	TWeakObjectPtr<UEnhancedInputComponent> BoundInputComponent;
+	TWeakObjectPtr<UTP_WeaponComponent> BoundWeapon;
+};
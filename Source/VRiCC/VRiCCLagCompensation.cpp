@@ -0,0 +1,413 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCLagCompensation.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCStats.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+static TAutoConsoleVariable<float> CVarLagCompRecordRate(
+	TEXT("VRiCC.LagComp.RecordRate"),
+	30.f,
+	TEXT("How many times per second the server records character hitboxes for rewinding shots."));
+
+static TAutoConsoleVariable<float> CVarLagCompMaxRewind(
+	TEXT("VRiCC.LagComp.MaxRewind"),
+	0.5f,
+	TEXT("Maximum time in seconds a client shot is allowed to rewind hitboxes."));
+
+static FAutoConsoleCommandWithWorldAndArgs GHitboxBenchmarkCommand(
+	TEXT("VRiCC.Hitbox.Benchmark"),
+	TEXT("VRiCC.Hitbox.Benchmark [NumRays=1000] [NumCharacters=64]: hitbox kernel versus LineTraceSingleByChannel on the same body part shapes."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UVRiCCLagCompensationSubsystem* LagCompensation = World != nullptr ? World->GetSubsystem<UVRiCCLagCompensationSubsystem>() : nullptr)
+		{
+			const int32 NumRays = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 1000;
+			const int32 NumCharacters = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64;
+			LagCompensation->RunHitboxBenchmark(FMath::Max(NumRays, 1), FMath::Max(NumCharacters, 1));
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// FVRiCCHitboxHistory
+
+static_assert((FVRiCCHitboxHistory::Capacity & (FVRiCCHitboxHistory::Capacity - 1)) == 0, "Hitbox history capacity must be a power of two");
+
+void FVRiCCHitboxHistory::Record(const FVRiCCHitboxPose& Pose)
+{
+	Poses[Head] = Pose;
+	Head = (Head + 1) & (Capacity - 1);
+	Num = FMath::Min(Num + 1, Capacity);
+}
+
+bool FVRiCCHitboxHistory::Sample(double Time, FVRiCCHitboxPose& OutPose) const
+{
+	if (Num == 0)
+	{
+		return false;
+	}
+
+	const FVRiCCHitboxPose* After = &Poses[(Head - 1) & (Capacity - 1)];
+	if (Time >= After->Time)
+	{
+		OutPose = *After;
+		return true;
+	}
+
+	// walk back from the newest pose until we find the pair bracketing Time
+	for (int32 Step = 1; Step < Num; ++Step)
+	{
+		const FVRiCCHitboxPose& Before = Poses[(Head - 1 - Step) & (Capacity - 1)];
+		if (Before.Time <= Time)
+		{
+			const double Span = After->Time - Before.Time;
+			const float Alpha = Span > UE_SMALL_NUMBER ? float((Time - Before.Time) / Span) : 0.f;
+
+			OutPose.Time = Time;
+			OutPose.Center = FMath::Lerp(Before.Center, After->Center, Alpha);
+			OutPose.Radius = FMath::Lerp(Before.Radius, After->Radius, Alpha);
+			OutPose.HalfHeight = FMath::Lerp(Before.HalfHeight, After->HalfHeight, Alpha);
+			OutPose.Yaw = Before.Yaw + FRotator::NormalizeAxis(After->Yaw - Before.Yaw) * Alpha;
+			return true;
+		}
+		After = &Before;
+	}
+
+	// older than anything we still have
+	OutPose = *After;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UVRiCCLagCompensationSubsystem
+
+bool UVRiCCLagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UVRiCCLagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCLagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void UVRiCCLagCompensationSubsystem::Tick(float DeltaTime)
+{
+	VRICC_SCOPE_CYCLE(LagCompensation);
+
+	UWorld* World = GetWorld();
+
+	// only the server validates shots
+	if (World == nullptr || World->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	const double Now = World->GetTimeSeconds();
+	const double RecordInterval = 1.0 / FMath::Max(CVarLagCompRecordRate.GetValueOnGameThread(), 1.f);
+	if (Now - LastRecordTime >= RecordInterval)
+	{
+		LastRecordTime = Now;
+		RecordPoses(Now);
+	}
+}
+
+void UVRiCCLagCompensationSubsystem::RecordPoses(double Time)
+{
+	for (AVRiCCCharacter* Character : Characters)
+	{
+		if (Character != nullptr)
+		{
+			Character->GetHitboxHistory().Record(Character->GetHitboxPose(Time));
+		}
+	}
+}
+
+void UVRiCCLagCompensationSubsystem::RegisterCharacter(AVRiCCCharacter* Character)
+{
+	if (Character != nullptr)
+	{
+		Character->GetHitboxHistory().Reset();
+		Characters.AddUnique(Character);
+	}
+}
+
+void UVRiCCLagCompensationSubsystem::UnregisterCharacter(AVRiCCCharacter* Character)
+{
+	Characters.RemoveSwap(Character);
+}
+
+double UVRiCCLagCompensationSubsystem::GetMaxRewind()
+{
+	return CVarLagCompMaxRewind.GetValueOnAnyThread();
+}
+
+bool UVRiCCLagCompensationSubsystem::RewindTrace(const FVector& Start, const FVector& End, double ShotTime, const AActor* IgnoreActor, FVRiCCRewindHit& OutHit) const
+{
+	// shots newer than the last record use the live capsule instead of the slightly stale newest pose
+	const bool bUseLivePose = ShotTime >= LastRecordTime;
+
+	TArray<FVRiCCHitboxTarget, TInlineAllocator<16>> Targets;
+	for (AVRiCCCharacter* Character : Characters)
+	{
+		if (Character != nullptr)
+		{
+			FVRiCCHitboxTarget& Target = Targets.AddDefaulted_GetRef();
+			Target.Character = Character;
+			Target.History = &Character->GetHitboxHistory();
+			if (bUseLivePose)
+			{
+				Target.LivePose = Character->GetHitboxPose(ShotTime);
+			}
+		}
+	}
+
+	return RewindTraceTargets(Targets, Start, End, ShotTime, bUseLivePose, IgnoreActor, OutHit);
+}
+
+void UVRiCCLagCompensationSubsystem::GatherTargets(TArray<FVRiCCHitboxTarget>& OutTargets) const
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	OutTargets.Reset();
+	for (AVRiCCCharacter* Character : Characters)
+	{
+		if (Character != nullptr)
+		{
+			FVRiCCHitboxTarget& Target = OutTargets.AddDefaulted_GetRef();
+			Target.Character = Character;
+			Target.History = &Character->GetHitboxHistory();
+			Target.LivePose = Character->GetHitboxPose(Now);
+		}
+	}
+}
+
+bool UVRiCCLagCompensationSubsystem::RewindTraceTargets(TConstArrayView<FVRiCCHitboxTarget> Targets, const FVector& Start, const FVector& End, double ShotTime, bool bUseLivePose, const AActor* IgnoreActor, FVRiCCRewindHit& OutHit)
+{
+	OutHit = FVRiCCRewindHit();
+
+	const FVector Delta = End - Start;
+	const double MaxDistance = Delta.Size();
+	if (MaxDistance <= UE_SMALL_NUMBER || Targets.Num() == 0)
+	{
+		return false;
+	}
+	const FVector3f Direction(Delta / MaxDistance);
+
+	// broadphase: the character capsule of every target at ShotTime
+	FVRiCCCapsuleSoA Bounds;
+	TArray<FVRiCCHitboxPose, TInlineAllocator<FVRiCCCapsuleSoA::InlineCapsules>> Poses;
+	TArray<int32, TInlineAllocator<FVRiCCCapsuleSoA::InlineCapsules>> PoseTargets;
+	FVRiCCHitboxPose Pose;
+
+	for (int32 TargetIndex = 0; TargetIndex < Targets.Num(); ++TargetIndex)
+	{
+		const FVRiCCHitboxTarget& Target = Targets[TargetIndex];
+		if (Target.Character != nullptr && Target.Character == IgnoreActor)
+		{
+			continue;
+		}
+
+		if (bUseLivePose)
+		{
+			Pose = Target.LivePose;
+		}
+		else if (Target.History == nullptr || !Target.History->Sample(ShotTime, Pose))
+		{
+			continue;
+		}
+
+		Bounds.Add(Pose.Center, Pose.Radius, Pose.HalfHeight - Pose.Radius);
+		Poses.Add(Pose);
+		PoseTargets.Add(TargetIndex);
+	}
+
+	TArray<float, TInlineAllocator<FVRiCCCapsuleSoA::InlineCapsules>> BoundDistances;
+	BoundDistances.SetNumUninitialized(Bounds.CenterX.Num());
+	Bounds.IntersectRayAll(Start, Direction, BoundDistances);
+
+	// narrowphase: body parts of the capsules the ray enters, nearest first. A part is never
+	// closer than its capsule, so once a capsule starts beyond the best part hit the search is over
+	TArray<int32, TInlineAllocator<16>> Candidates;
+	for (int32 Index = 0; Index < Bounds.Num(); ++Index)
+	{
+		if (BoundDistances[Index] < MaxDistance)
+		{
+			Candidates.Add(Index);
+		}
+	}
+	Candidates.Sort([&BoundDistances](int32 A, int32 B) { return BoundDistances[A] < BoundDistances[B]; });
+
+	float BestDistance = float(MaxDistance);
+	FVRiCCCapsuleSoA Parts;
+	FVRiCCCapsuleSoA BestParts;
+	int32 BestPart = INDEX_NONE;
+
+	for (int32 Candidate : Candidates)
+	{
+		if (BoundDistances[Candidate] >= BestDistance)
+		{
+			break;
+		}
+
+		const FVRiCCHitboxPose& CandidatePose = Poses[Candidate];
+		Parts.Reset();
+		VRiCCHitboxes::AddBodyParts(Parts, CandidatePose.Center, CandidatePose.Radius, CandidatePose.HalfHeight, CandidatePose.Yaw);
+
+		float PartDistance;
+		const int32 PartIndex = Parts.IntersectRay(Start, Direction, BestDistance, PartDistance);
+		if (PartIndex != INDEX_NONE)
+		{
+			BestDistance = PartDistance;
+			BestPart = PartIndex;
+			BestParts = Parts;
+			OutHit.TargetIndex = PoseTargets[Candidate];
+		}
+	}
+
+	if (OutHit.TargetIndex == INDEX_NONE)
+	{
+		return false;
+	}
+
+	OutHit.Character = Targets[OutHit.TargetIndex].Character;
+	OutHit.BodyPart = VRiCCHitboxes::GetBodyPart(BestPart);
+	OutHit.Distance = BestDistance;
+	OutHit.Location = Start + FVector(Direction) * BestDistance;
+	OutHit.Normal = BestParts.GetSurfaceNormal(BestPart, OutHit.Location);
+	return true;
+}
+
+void UVRiCCLagCompensationSubsystem::RunHitboxBenchmark(int32 NumRays, int32 NumCharacters)
+{
+	UWorld* World = GetWorld();
+
+	// characters far above the level so the physics traces only find the benchmark shapes
+	const FVector Origin(0.0, 0.0, 500000.0);
+	FRandomStream Random(NumRays);
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	SpawnParams.ObjectFlags |= RF_Transient;
+
+	TArray<AActor*> Actors;
+	TArray<FVRiCCHitboxTarget> Targets;
+	Targets.SetNum(NumCharacters);
+
+	for (FVRiCCHitboxTarget& Target : Targets)
+	{
+		FVRiCCHitboxPose& Pose = Target.LivePose;
+		Pose.Center = FVector3f(Origin + FVector(Random.FRandRange(-5000.f, 5000.f), Random.FRandRange(-5000.f, 5000.f), 0.0));
+		Pose.Radius = 55.f;
+		Pose.HalfHeight = 96.f;
+		Pose.Yaw = Random.FRandRange(-180.f, 180.f);
+
+		// one physics capsule per body part, so both sides test the same shapes
+		FVRiCCCapsuleSoA Parts;
+		VRiCCHitboxes::AddBodyParts(Parts, Pose.Center, Pose.Radius, Pose.HalfHeight, Pose.Yaw);
+
+		AActor* Actor = World->SpawnActor<AActor>(AActor::StaticClass(), FTransform(FVector(Pose.Center)), SpawnParams);
+		if (Actor == nullptr)
+		{
+			continue;
+		}
+		Actors.Add(Actor);
+
+		for (int32 PartIndex = 0; PartIndex < Parts.Num(); ++PartIndex)
+		{
+			UCapsuleComponent* Shape = NewObject<UCapsuleComponent>(Actor);
+			Shape->InitCapsuleSize(Parts.Radius[PartIndex], Parts.SegmentHalf[PartIndex] + Parts.Radius[PartIndex]);
+			Shape->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+			Shape->SetCollisionObjectType(ECC_Pawn);
+			Shape->SetCollisionResponseToAllChannels(ECR_Block);
+			if (PartIndex == 0)
+			{
+				Actor->SetRootComponent(Shape);
+			}
+			else
+			{
+				Shape->SetupAttachment(Actor->GetRootComponent());
+			}
+			Shape->RegisterComponent();
+			Shape->SetWorldLocation(FVector(Parts.CenterX[PartIndex], Parts.CenterY[PartIndex], Parts.CenterZ[PartIndex]));
+		}
+	}
+
+	// rays from one edge of the square at random characters, jittered so some of them miss,
+	// every eighth one fired point blank from inside its target
+	TArray<TPair<FVector, FVector>> Rays;
+	Rays.SetNum(NumRays);
+	for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+	{
+		TPair<FVector, FVector>& Ray = Rays[RayIndex];
+		const FVector Center(Targets[Random.RandHelper(NumCharacters)].LivePose.Center);
+		const FVector Aim = Center + FVector(0.0, 0.0, Random.FRandRange(-120.f, 120.f));
+		if (RayIndex % 8 == 0)
+		{
+			Ray.Key = Center + FVector(Random.FRandRange(-10.f, 10.f), Random.FRandRange(-10.f, 10.f), Random.FRandRange(-40.f, 40.f));
+			Ray.Value = Ray.Key + FVector(0.0, 1.0, 0.0) * 20000.0;
+		}
+		else
+		{
+			Ray.Key = Origin + FVector(Random.FRandRange(-6000.f, 6000.f), -7000.0, Random.FRandRange(-50.f, 50.f));
+			Ray.Value = Ray.Key + (Aim - Ray.Key).GetSafeNormal() * 20000.0;
+		}
+	}
+
+	double StartSeconds = FPlatformTime::Seconds();
+	TBitArray<> PhysicsHits(false, NumRays);
+	TArray<float> PhysicsDistances;
+	PhysicsDistances.SetNumZeroed(NumRays);
+	const FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(VRiCCHitboxBenchmark), false);
+	for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+	{
+		FHitResult Hit;
+		PhysicsHits[RayIndex] = World->LineTraceSingleByChannel(Hit, Rays[RayIndex].Key, Rays[RayIndex].Value, ECC_GameTraceChannel1, QueryParams);
+		PhysicsDistances[RayIndex] = Hit.bStartPenetrating ? 0.f : Hit.Distance;
+	}
+	const double PhysicsMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+	StartSeconds = FPlatformTime::Seconds();
+	TBitArray<> KernelHits(false, NumRays);
+	TArray<float> KernelDistances;
+	KernelDistances.SetNumZeroed(NumRays);
+	for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+	{
+		FVRiCCRewindHit Hit;
+		KernelHits[RayIndex] = RewindTraceTargets(Targets, Rays[RayIndex].Key, Rays[RayIndex].Value, 0.0, true, nullptr, Hit);
+		KernelDistances[RayIndex] = Hit.Distance;
+	}
+	const double KernelMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+	int32 NumPhysicsHits = 0;
+	int32 NumKernelHits = 0;
+	int32 NumAgreeing = 0;
+	int32 NumInside = 0;
+	int32 NumInsideAgreeing = 0;
+	for (int32 RayIndex = 0; RayIndex < NumRays; ++RayIndex)
+	{
+		NumPhysicsHits += PhysicsHits[RayIndex] ? 1 : 0;
+		NumKernelHits += KernelHits[RayIndex] ? 1 : 0;
+		NumAgreeing += PhysicsHits[RayIndex] == KernelHits[RayIndex] ? 1 : 0;
+
+		// point blank rays also have to agree on whether they started inside a body part
+		if (RayIndex % 8 == 0)
+		{
+			NumInside++;
+			const bool bPhysicsInside = PhysicsHits[RayIndex] && PhysicsDistances[RayIndex] == 0.f;
+			const bool bKernelInside = KernelHits[RayIndex] && KernelDistances[RayIndex] == 0.f;
+			NumInsideAgreeing += bPhysicsInside == bKernelInside ? 1 : 0;
+		}
+	}
+
+	for (AActor* Actor : Actors)
+	{
+		Actor->Destroy();
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("Hitbox benchmark, %d rays x %d characters: LineTraceSingleByChannel %.3fms (%d hits), kernel %.3fms (%d hits), %.1fx, %d/%d rays agree, %d/%d point blank rays agree on starting inside"),
+		NumRays, NumCharacters, PhysicsMs, NumPhysicsHits, KernelMs, NumKernelHits, KernelMs > 0.0 ? PhysicsMs / KernelMs : 0.0, NumAgreeing, NumRays, NumInsideAgreeing, NumInside);
+}
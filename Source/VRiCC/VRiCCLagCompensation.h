@@ -0,0 +1,123 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/StaticArray.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCHitboxKernel.h"
+#include "VRiCCLagCompensation.generated.h"
+
+class AVRiCCCharacter;
+
+/** Capsule hitbox of a character at one point in server time */
+struct FVRiCCHitboxPose
+{
+	double Time = 0.0;
+	FVector3f Center = FVector3f::ZeroVector;
+	float Radius = 0.f;
+	float HalfHeight = 0.f;
+
+	/** Facing of the character in degrees, turns the body parts inside the capsule */
+	float Yaw = 0.f;
+};
+
+/**
+ * Fixed-size ring buffer of hitbox poses.
+ * Stored inline in the character so recording and rewinding never allocate.
+ */
+struct VRICC_API FVRiCCHitboxHistory
+{
+	/** Must be a power of two, ~1 second of history at the default 30Hz record rate */
+	static constexpr int32 Capacity = 32;
+
+	void Record(const FVRiCCHitboxPose& Pose);
+
+	/** Interpolates the pose at Time, clamped to the recorded range. Returns false if nothing was recorded yet */
+	bool Sample(double Time, FVRiCCHitboxPose& OutPose) const;
+
+	void Reset() { Head = 0; Num = 0; }
+	int32 GetNum() const { return Num; }
+
+private:
+	TStaticArray<FVRiCCHitboxPose, Capacity> Poses;
+
+	/** Slot the next pose is written to */
+	int32 Head = 0;
+	int32 Num = 0;
+};
+
+/**
+ * A character's hitboxes as seen by a batch of rewind traces.
+ * Gathered on the game thread, worker threads only read the history while the game thread waits for them.
+ */
+struct FVRiCCHitboxTarget
+{
+	/** Only compared and handed back, never dereferenced off the game thread */
+	AVRiCCCharacter* Character = nullptr;
+	const FVRiCCHitboxHistory* History = nullptr;
+
+	/** Capsule at gather time, used for shots newer than the last recorded pose */
+	FVRiCCHitboxPose LivePose;
+};
+
+/** Result of a shot traced against rewound hitboxes */
+struct FVRiCCRewindHit
+{
+	AVRiCCCharacter* Character = nullptr;
+	int32 TargetIndex = INDEX_NONE;
+	EVRiCCBodyPart BodyPart = EVRiCCBodyPart::None;
+	FVector Location = FVector::ZeroVector;
+	FVector Normal = FVector::ZeroVector;
+	double Distance = 0.0;
+};
+
+/**
+ * Character hitboxes for weapon traces, which only see world geometry.
+ * On the server it records the capsule of every registered character at a fixed rate and re-traces
+ * client shots against the poses from the time the shooter saw them, clients test the live capsules.
+ * Each capsule is tested against the ray first, then the body parts inside it with the SIMD hitbox kernel.
+ */
+UCLASS()
+class VRICC_API UVRiCCLagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	void RegisterCharacter(AVRiCCCharacter* Character);
+	void UnregisterCharacter(AVRiCCCharacter* Character);
+
+	/** Traces Start->End against every registered character as it was at ShotTime and returns the closest hit */
+	bool RewindTrace(const FVector& Start, const FVector& End, double ShotTime, const AActor* IgnoreActor, FVRiCCRewindHit& OutHit) const;
+
+	/** Snapshots every registered character for a batch of RewindTraceTargets calls */
+	void GatherTargets(TArray<FVRiCCHitboxTarget>& OutTargets) const;
+
+	/** Shots at or after this time are traced against the live capsules instead of the history */
+	double GetLastRecordTime() const { return LastRecordTime; }
+
+	/** Maximum rewind in seconds, VRiCC.LagComp.MaxRewind */
+	static double GetMaxRewind();
+
+	/** RewindTrace against gathered targets, touches no UObject so it is safe on worker threads */
+	static bool RewindTraceTargets(TConstArrayView<FVRiCCHitboxTarget> Targets, const FVector& Start, const FVector& End, double ShotTime, bool bUseLivePose, const AActor* IgnoreActor, FVRiCCRewindHit& OutHit);
+
+	/** Times NumRays rays against NumCharacters characters, through the hitbox kernel and through LineTraceSingleByChannel on matching physics shapes */
+	void RunHitboxBenchmark(int32 NumRays, int32 NumCharacters);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void RecordPoses(double Time);
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AVRiCCCharacter>> Characters;
+
+	double LastRecordTime = -UE_BIG_NUMBER;
+};
@@ -0,0 +1,609 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCPerfSuite.h"
+#include "TP_WeaponComponent.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCDamage.h"
+#include "VRiCCProjectile.h"
+#include "VRiCCProjectileManager.h"
+#include "VRiCCProjectilePool.h"
+#include "VRiCCTraceQueue.h"
+#include "WeaponSpawner.h"
+#include "Dom/JsonObject.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameModeBase.h"
+#include "GameFramework/PlayerStart.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+
+static TAutoConsoleVariable<int32> CVarPerfSuiteWarmupFrames(
+	TEXT("VRiCC.PerfSuite.WarmupFrames"),
+	30,
+	TEXT("Frames each perf suite run plays before it starts measuring."));
+
+static TAutoConsoleVariable<int32> CVarPerfSuiteMeasureFrames(
+	TEXT("VRiCC.PerfSuite.MeasureFrames"),
+	120,
+	TEXT("Frames each perf suite run is measured for."));
+
+static TAutoConsoleVariable<float> CVarPerfSuiteThreshold(
+	TEXT("VRiCC.PerfSuite.Threshold"),
+	0.15f,
+	TEXT("A run regressed when its hot path costs this fraction more than the baseline, -VRiCCPerfThreshold=X overrides it."));
+
+static TAutoConsoleVariable<float> CVarPerfSuiteMinRegressionMs(
+	TEXT("VRiCC.PerfSuite.MinRegressionMs"),
+	0.05f,
+	TEXT("Slowdowns smaller than this many milliseconds are noise, not regressions."));
+
+static FAutoConsoleCommandWithWorldAndArgs GPerfSuiteRunCommand(
+	TEXT("VRiCC.PerfSuite.Run"),
+	TEXT("Runs the perf suite in this world. Usage: VRiCC.PerfSuite.Run [Scale...], defaults to 1 16 64 256."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UVRiCCPerfSuiteSubsystem* PerfSuite = World != nullptr ? World->GetSubsystem<UVRiCCPerfSuiteSubsystem>() : nullptr;
+		if (PerfSuite == nullptr || PerfSuite->IsRunning())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("PerfSuite: not available in this world or already running"));
+			return;
+		}
+
+		TArray<int32> Scales;
+		for (const FString& Arg : Args)
+		{
+			Scales.Add(FMath::Max(FCString::Atoi(*Arg), 1));
+		}
+		PerfSuite->StartSuite(Scales, false);
+	}));
+
+namespace VRiCCPerfSuite
+{
+	static const int32 DefaultScales[] = { 1, 16, 64, 256 };
+	static const EVRiCCPerfScenario Scenarios[] = { EVRiCCPerfScenario::Fire, EVRiCCPerfScenario::Projectiles, EVRiCCPerfScenario::Pickups, EVRiCCPerfScenario::Damage };
+
+	/** Shooters stand in rows of this many, far enough apart that their capsules and pickups never touch */
+	static constexpr int32 Columns = 16;
+	static constexpr double Spacing = 400.0;
+
+	/** A shooter's pickup waits this far to its side */
+	static constexpr double PickupOffset = 200.0;
+
+	/** Frames between two projectiles of one shooter, about the auto fire rate at 60 fps */
+	static constexpr int32 ProjectileInterval = 6;
+
+	static float Average(const TArray<float>& Values)
+	{
+		double Sum = 0.0;
+		for (float Value : Values)
+		{
+			Sum += Value;
+		}
+		return Values.Num() > 0 ? float(Sum / Values.Num()) : 0.f;
+	}
+
+	static float Percentile95(TArray<float> Values)
+	{
+		if (Values.Num() == 0)
+		{
+			return 0.f;
+		}
+		Values.Sort();
+		return Values[FMath::Min(int32(Values.Num() * 0.95f), Values.Num() - 1)];
+	}
+}
+
+const TCHAR* UVRiCCPerfSuiteSubsystem::GetScenarioName(EVRiCCPerfScenario Scenario)
+{
+	switch (Scenario)
+	{
+	case EVRiCCPerfScenario::Fire:
+		return TEXT("Fire");
+	case EVRiCCPerfScenario::Projectiles:
+		return TEXT("Projectiles");
+	case EVRiCCPerfScenario::Pickups:
+		return TEXT("Pickups");
+	case EVRiCCPerfScenario::Damage:
+		return TEXT("Damage");
+	}
+	return TEXT("Unknown");
+}
+
+bool UVRiCCPerfSuiteSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UVRiCCPerfSuiteSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCPerfSuiteSubsystem, STATGROUP_Tickables);
+}
+
+void UVRiCCPerfSuiteSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// the server side of the game is what is measured, clients have nothing to spawn
+	if (InWorld.GetNetMode() != NM_Client && FParse::Param(FCommandLine::Get(), TEXT("VRiCCPerfSuite")))
+	{
+		TArray<int32> Scales;
+		FString ScalesValue;
+		if (FParse::Value(FCommandLine::Get(), TEXT("VRiCCPerfScales="), ScalesValue))
+		{
+			TArray<FString> Parts;
+			ScalesValue.ParseIntoArray(Parts, TEXT(","));
+			for (const FString& Part : Parts)
+			{
+				Scales.Add(FMath::Max(FCString::Atoi(*Part), 1));
+			}
+		}
+		StartSuite(Scales, true);
+	}
+}
+
+void UVRiCCPerfSuiteSubsystem::StartSuite(TConstArrayView<int32> Scales, bool bInExitWhenDone)
+{
+	UWorld* World = GetWorld();
+	if (Scales.Num() == 0)
+	{
+		Scales = VRiCCPerfSuite::DefaultScales;
+	}
+
+	// the same pawn and weapon the game uses, so the blueprint side of firing and pickups is measured too
+	ShooterClass = AVRiCCCharacter::StaticClass();
+	if (const AGameModeBase* GameMode = World->GetAuthGameMode())
+	{
+		if (GameMode->DefaultPawnClass != nullptr && GameMode->DefaultPawnClass->IsChildOf(AVRiCCCharacter::StaticClass()))
+		{
+			ShooterClass = GameMode->DefaultPawnClass;
+		}
+	}
+
+	WeaponClass = nullptr;
+	for (TActorIterator<AWeaponSpawner> It(World); It; ++It)
+	{
+		if (It->WeaponClass != nullptr)
+		{
+			WeaponClass = It->WeaponClass;
+			break;
+		}
+	}
+	ProjectileClass = AVRiCCProjectile::StaticClass();
+
+	// above the first player start, shooters do not move so nothing needs to hold them up
+	Origin = FVector(0.0, 0.0, 500.0);
+	for (TActorIterator<APlayerStart> It(World); It; ++It)
+	{
+		Origin = It->GetActorLocation() + FVector(0.0, 0.0, 300.0);
+		break;
+	}
+
+	Runs.Reset();
+	for (int32 NumActors : Scales)
+	{
+		for (EVRiCCPerfScenario Scenario : VRiCCPerfSuite::Scenarios)
+		{
+			Runs.Add({ Scenario, NumActors });
+		}
+	}
+
+	Results.Reset();
+	RunIndex = 0;
+	RunFrame = 0;
+	bExitWhenDone = bInExitWhenDone;
+	bRunning = true;
+
+	UE_LOG(LogTemp, Display, TEXT("PerfSuite: %d runs, shooter %s, weapon %s"), Runs.Num(), *GetNameSafe(ShooterClass), *GetNameSafe(WeaponClass));
+}
+
+void UVRiCCPerfSuiteSubsystem::Tick(float DeltaTime)
+{
+	const FRun& Run = Runs[RunIndex];
+
+	if (RunFrame == 0)
+	{
+		FrameMs.Reset();
+		WorkMs.Reset();
+		if (!SetUpRun(Run))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("PerfSuite: skipped %s x%d"), GetScenarioName(Run.Scenario), Run.NumActors);
+			TearDownRun();
+			RunIndex++;
+			if (RunIndex >= Runs.Num())
+			{
+				FinishSuite();
+			}
+			return;
+		}
+		RunFrame++;
+		return;
+	}
+
+	const int32 WarmupFrames = FMath::Max(CVarPerfSuiteWarmupFrames.GetValueOnGameThread(), 0);
+	const int32 MeasureFrames = FMath::Max(CVarPerfSuiteMeasureFrames.GetValueOnGameThread(), 1);
+
+	const double Work = DriveFrame(Run, RunFrame);
+	if (RunFrame > WarmupFrames)
+	{
+		// the frame that just ended, the same measure the soak report uses
+		FrameMs.Add(float((FApp::GetDeltaTime() - FApp::GetIdleTime()) * 1000.0));
+		if (Work >= 0.0)
+		{
+			WorkMs.Add(float(Work));
+		}
+	}
+
+	if (++RunFrame > WarmupFrames + MeasureFrames)
+	{
+		FinishRun(Run);
+		TearDownRun();
+		RunFrame = 0;
+		if (++RunIndex >= Runs.Num())
+		{
+			FinishSuite();
+		}
+	}
+}
+
+bool UVRiCCPerfSuiteSubsystem::SetUpRun(const FRun& Run)
+{
+	const bool bNeedsWeapons = Run.Scenario == EVRiCCPerfScenario::Fire || Run.Scenario == EVRiCCPerfScenario::Pickups;
+	if (bNeedsWeapons && WeaponClass == nullptr)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("PerfSuite: no weapon spawner with a weapon class in this map"));
+		return false;
+	}
+
+	for (int32 Index = 0; Index < Run.NumActors; ++Index)
+	{
+		AVRiCCCharacter* Shooter = SpawnShooter(GetSlotLocation(Index));
+		if (Shooter == nullptr)
+		{
+			return false;
+		}
+		Shooters.Add(Shooter);
+
+		if (Run.Scenario == EVRiCCPerfScenario::Fire)
+		{
+			AActor* Weapon = SpawnWeapon(Shooter->GetActorLocation());
+			if (UTP_WeaponComponent* WeaponComponent = Weapon != nullptr ? Weapon->FindComponentByClass<UTP_WeaponComponent>() : nullptr)
+			{
+				WeaponComponent->AttachWeapon(Shooter);
+			}
+		}
+	}
+	return true;
+}
+
+void UVRiCCPerfSuiteSubsystem::TearDownRun()
+{
+	for (const TWeakObjectPtr<AVRiCCCharacter>& Shooter : Shooters)
+	{
+		if (AVRiCCCharacter* Character = Shooter.Get())
+		{
+			if (UTP_WeaponComponent* Weapon = Character->GetWeapon())
+			{
+				Weapon->GetOwner()->Destroy();
+			}
+			Character->Destroy();
+		}
+	}
+	for (const TWeakObjectPtr<AActor>& Prop : Props)
+	{
+		if (AActor* Actor = Prop.Get())
+		{
+			Actor->Destroy();
+		}
+	}
+	Shooters.Reset();
+	Props.Reset();
+
+	// projectiles of this run would otherwise be simulated during the next one
+	if (UVRiCCProjectileManager* ProjectileManager = GetWorld()->GetSubsystem<UVRiCCProjectileManager>())
+	{
+		ProjectileManager->RemoveAllProjectiles();
+	}
+}
+
+double UVRiCCPerfSuiteSubsystem::DriveFrame(const FRun& Run, int32 Frame)
+{
+	UWorld* World = GetWorld();
+	double StartSeconds = FPlatformTime::Seconds();
+	double ExtraMs = 0.0;
+
+	switch (Run.Scenario)
+	{
+	case EVRiCCPerfScenario::Fire:
+		for (const TWeakObjectPtr<AVRiCCCharacter>& Shooter : Shooters)
+		{
+			AVRiCCCharacter* Character = Shooter.Get();
+			UTP_WeaponComponent* Weapon = Character != nullptr ? Character->GetWeapon() : nullptr;
+			if (Weapon != nullptr)
+			{
+				// never reload, every frame is a shot
+				Character->VRiCC_ShotsLeft = Character->VRiCC_ShotsPerRack;
+				Weapon->FireAndHit();
+			}
+		}
+
+		// the shots of the frame before are delivered, impacted and resolved in the trace queue's own tick,
+		// its game thread time already contains the shot resolver batch it runs
+		if (const UVRiCCTraceQueueSubsystem* TraceQueue = World->GetSubsystem<UVRiCCTraceQueueSubsystem>())
+		{
+			ExtraMs = TraceQueue->GetStats().GameThreadMs;
+		}
+		break;
+
+	case EVRiCCPerfScenario::Projectiles:
+	{
+		UVRiCCProjectileManager* ProjectileManager = World->GetSubsystem<UVRiCCProjectileManager>();
+		UVRiCCProjectilePoolSubsystem* ProjectilePool = World->GetSubsystem<UVRiCCProjectilePoolSubsystem>();
+		const bool bSimulated = ProjectileManager != nullptr && UVRiCCProjectileManager::IsSimulationEnabled();
+		for (int32 Index = 0; Index < Shooters.Num(); ++Index)
+		{
+			AVRiCCCharacter* Character = Shooters[Index].Get();
+			if (Character == nullptr || (Frame + Index) % VRiCCPerfSuite::ProjectileInterval != 0)
+			{
+				continue;
+			}
+
+			const FRotator Rotation(10.0, Character->GetActorRotation().Yaw + (Index % 8) * 45.0, 0.0);
+			const FVector Location = Character->GetActorLocation() + Rotation.Vector() * 100.0;
+			if (bSimulated)
+			{
+				ProjectileManager->SpawnProjectile(ProjectileClass, Location, Rotation.Vector(), Character);
+			}
+			else if (ProjectilePool != nullptr)
+			{
+				ProjectilePool->Acquire(ProjectileClass, FTransform(Rotation, Location), Character, Character);
+			}
+		}
+
+		// the simulation of the frame before runs in the manager's own tick
+		if (bSimulated)
+		{
+			const FVRiCCProjectileManagerStats& Stats = ProjectileManager->GetStats();
+			ExtraMs = Stats.IntegrateMs + Stats.SweepMs + Stats.ResolveMs;
+		}
+		break;
+	}
+
+	case EVRiCCPerfScenario::Pickups:
+		// even frames lay out fresh pickups next to unarmed shooters, odd frames walk every shooter into one
+		if (Frame % 2 == 1)
+		{
+			for (int32 Index = 0; Index < Shooters.Num(); ++Index)
+			{
+				if (AVRiCCCharacter* Character = Shooters[Index].Get())
+				{
+					Character->SetActorLocation(GetSlotLocation(Index) + FVector(0.0, VRiCCPerfSuite::PickupOffset, 0.0), false, nullptr, ETeleportType::TeleportPhysics);
+				}
+			}
+			break;
+		}
+
+		Props.RemoveAll([](const TWeakObjectPtr<AActor>& Prop) { return !Prop.IsValid(); });
+		for (int32 Index = 0; Index < Shooters.Num(); ++Index)
+		{
+			AVRiCCCharacter* Character = Shooters[Index].Get();
+			if (Character == nullptr)
+			{
+				continue;
+			}
+
+			if (UTP_WeaponComponent* Weapon = Character->GetWeapon())
+			{
+				Weapon->GetOwner()->Destroy();
+				Character->SetWeapon(nullptr);
+				Character->SetHasRifle(false);
+			}
+			Character->SetActorLocation(GetSlotLocation(Index), false, nullptr, ETeleportType::TeleportPhysics);
+			Props.Add(SpawnWeapon(GetSlotLocation(Index) + FVector(0.0, VRiCCPerfSuite::PickupOffset, 0.0)));
+		}
+		return -1.0;
+
+	case EVRiCCPerfScenario::Damage:
+	{
+		for (int32 Index = 0; Index < Shooters.Num(); ++Index)
+		{
+			AVRiCCCharacter* Character = Shooters[Index].Get();
+			if (Character == nullptr)
+			{
+				continue;
+			}
+
+			// nobody dies, every frame is a hit on a living character
+			if (Character->VRiCC_Health < 0.2f)
+			{
+				Character->VRiCC_Health = 1.f;
+			}
+			AVRiCCCharacter* Instigator = Shooters[(Index + 1) % Shooters.Num()].Get();
+			Character->TakeDamage(0.01f, FDamageEvent(), nullptr, Instigator);
+		}
+
+		// the hits of the frame before were applied after that frame's actor tick
+		if (const UVRiCCDamageSubsystem* DamageSubsystem = World->GetSubsystem<UVRiCCDamageSubsystem>())
+		{
+			ExtraMs = DamageSubsystem->GetStats().ApplyMs;
+		}
+		break;
+	}
+	}
+
+	return (FPlatformTime::Seconds() - StartSeconds) * 1000.0 + ExtraMs;
+}
+
+AVRiCCCharacter* UVRiCCPerfSuiteSubsystem::SpawnShooter(const FVector& Location)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	AVRiCCCharacter* Shooter = GetWorld()->SpawnActor<AVRiCCCharacter>(ShooterClass, Location, FRotator::ZeroRotator, SpawnParams);
+	if (Shooter != nullptr)
+	{
+		// shooters stand still in mid air, only the scenarios move them
+		Shooter->GetCharacterMovement()->GravityScale = 0.f;
+		Shooter->GetCharacterMovement()->DisableMovement();
+	}
+	return Shooter;
+}
+
+AActor* UVRiCCPerfSuiteSubsystem::SpawnWeapon(const FVector& Location)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AActor>(WeaponClass, Location, FRotator::ZeroRotator, SpawnParams);
+}
+
+FVector UVRiCCPerfSuiteSubsystem::GetSlotLocation(int32 Index) const
+{
+	const int32 Column = Index % VRiCCPerfSuite::Columns;
+	const int32 Row = Index / VRiCCPerfSuite::Columns;
+	return Origin + FVector(Row * VRiCCPerfSuite::Spacing, Column * VRiCCPerfSuite::Spacing, 0.0);
+}
+
+void UVRiCCPerfSuiteSubsystem::FinishRun(const FRun& Run)
+{
+	FVRiCCPerfResult& Result = Results.AddDefaulted_GetRef();
+	Result.Scenario = Run.Scenario;
+	Result.NumActors = Run.NumActors;
+	Result.NumFrames = FrameMs.Num();
+	Result.FrameMsAvg = VRiCCPerfSuite::Average(FrameMs);
+	Result.FrameMsP95 = VRiCCPerfSuite::Percentile95(FrameMs);
+	Result.WorkMsAvg = VRiCCPerfSuite::Average(WorkMs);
+	Result.WorkMsP95 = VRiCCPerfSuite::Percentile95(WorkMs);
+
+	UE_LOG(LogTemp, Display, TEXT("PerfSuite: %s x%d frame avg %.3fms p95 %.3fms, work avg %.3fms p95 %.3fms"),
+		GetScenarioName(Run.Scenario), Run.NumActors, Result.FrameMsAvg, Result.FrameMsP95, Result.WorkMsAvg, Result.WorkMsP95);
+}
+
+void UVRiCCPerfSuiteSubsystem::FinishSuite()
+{
+	bRunning = false;
+
+	const FString PerfDir = FPaths::ProjectSavedDir() / TEXT("Perf");
+	FString BaselinePath = PerfDir / TEXT("Baseline.json");
+	FParse::Value(FCommandLine::Get(), TEXT("VRiCCPerfBaseline="), BaselinePath);
+
+	const bool bRegressed = CompareWithBaseline(BaselinePath);
+	for (const FVRiCCPerfResult& Result : Results)
+	{
+		if (Result.bRegressed)
+		{
+			UE_LOG(LogTemp, Error, TEXT("PerfSuite: %s x%d regressed, work %.3fms against %.3fms in the baseline"),
+				GetScenarioName(Result.Scenario), Result.NumActors, Result.WorkMsAvg, Result.BaselineWorkMsAvg);
+		}
+	}
+
+	const FString Json = ToJson();
+	const FString Path = PerfDir / FString::Printf(TEXT("PerfSuite-%s.json"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Json, *Path))
+	{
+		UE_LOG(LogTemp, Display, TEXT("PerfSuite: %d results written to %s"), Results.Num(), *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("PerfSuite: could not write %s"), *Path);
+	}
+
+	// -VRiCCPerfWriteBaseline makes this run the numbers later runs are held to
+	if (FParse::Param(FCommandLine::Get(), TEXT("VRiCCPerfWriteBaseline")) && FFileHelper::SaveStringToFile(Json, *BaselinePath))
+	{
+		UE_LOG(LogTemp, Display, TEXT("PerfSuite: baseline written to %s"), *BaselinePath);
+	}
+
+	UE_LOG(LogTemp, Display, TEXT("PerfSuite: %s"), bRegressed ? TEXT("FAILED, hot paths regressed") : TEXT("passed"));
+	if (bExitWhenDone)
+	{
+		FPlatformMisc::RequestExitWithStatus(false, bRegressed ? 1 : 0);
+	}
+}
+
+bool UVRiCCPerfSuiteSubsystem::CompareWithBaseline(const FString& BaselinePath)
+{
+	FString BaselineJson;
+	if (!FFileHelper::LoadFileToString(BaselineJson, *BaselinePath))
+	{
+		UE_LOG(LogTemp, Display, TEXT("PerfSuite: no baseline at %s, nothing to compare"), *BaselinePath);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> Baseline;
+	const TArray<TSharedPtr<FJsonValue>>* BaselineResults = nullptr;
+	if (!FJsonSerializer::Deserialize(TJsonReaderFactory<>::Create(BaselineJson), Baseline) || !Baseline.IsValid() || !Baseline->TryGetArrayField(TEXT("Results"), BaselineResults))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("PerfSuite: could not read the baseline %s"), *BaselinePath);
+		return false;
+	}
+
+	float Threshold = CVarPerfSuiteThreshold.GetValueOnGameThread();
+	FParse::Value(FCommandLine::Get(), TEXT("VRiCCPerfThreshold="), Threshold);
+	const float MinRegressionMs = CVarPerfSuiteMinRegressionMs.GetValueOnGameThread();
+
+	bool bRegressed = false;
+	for (FVRiCCPerfResult& Result : Results)
+	{
+		for (const TSharedPtr<FJsonValue>& Value : *BaselineResults)
+		{
+			const TSharedPtr<FJsonObject> Entry = Value->AsObject();
+			if (!Entry.IsValid() || Entry->GetStringField(TEXT("Scenario")) != GetScenarioName(Result.Scenario) || Entry->GetIntegerField(TEXT("Actors")) != Result.NumActors)
+			{
+				continue;
+			}
+
+			// only the hot path itself is held to the baseline, whole frames vary too much between machines
+			Result.BaselineFrameMsAvg = float(Entry->GetNumberField(TEXT("FrameMsAvg")));
+			Result.BaselineWorkMsAvg = float(Entry->GetNumberField(TEXT("WorkMsAvg")));
+			Result.bRegressed = Result.WorkMsAvg > Result.BaselineWorkMsAvg * (1.f + Threshold) + MinRegressionMs;
+			bRegressed |= Result.bRegressed;
+			break;
+		}
+	}
+	return bRegressed;
+}
+
+FString UVRiCCPerfSuiteSubsystem::ToJson() const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("Version"), 1);
+	Root->SetStringField(TEXT("Map"), GetWorld()->GetMapName());
+	Root->SetStringField(TEXT("Configuration"), LexToString(FApp::GetBuildConfiguration()));
+	Root->SetStringField(TEXT("Date"), FDateTime::UtcNow().ToIso8601());
+	Root->SetNumberField(TEXT("WarmupFrames"), CVarPerfSuiteWarmupFrames.GetValueOnGameThread());
+	Root->SetNumberField(TEXT("MeasureFrames"), CVarPerfSuiteMeasureFrames.GetValueOnGameThread());
+
+	bool bRegressed = false;
+	TArray<TSharedPtr<FJsonValue>> Entries;
+	for (const FVRiCCPerfResult& Result : Results)
+	{
+		TSharedRef<FJsonObject> Entry = MakeShared<FJsonObject>();
+		Entry->SetStringField(TEXT("Scenario"), GetScenarioName(Result.Scenario));
+		Entry->SetNumberField(TEXT("Actors"), Result.NumActors);
+		Entry->SetNumberField(TEXT("Frames"), Result.NumFrames);
+		Entry->SetNumberField(TEXT("FrameMsAvg"), Result.FrameMsAvg);
+		Entry->SetNumberField(TEXT("FrameMsP95"), Result.FrameMsP95);
+		Entry->SetNumberField(TEXT("WorkMsAvg"), Result.WorkMsAvg);
+		Entry->SetNumberField(TEXT("WorkMsP95"), Result.WorkMsP95);
+		if (Result.BaselineWorkMsAvg >= 0.f)
+		{
+			Entry->SetNumberField(TEXT("BaselineFrameMsAvg"), Result.BaselineFrameMsAvg);
+			Entry->SetNumberField(TEXT("BaselineWorkMsAvg"), Result.BaselineWorkMsAvg);
+		}
+		Entry->SetBoolField(TEXT("Regressed"), Result.bRegressed);
+		Entries.Add(MakeShared<FJsonValueObject>(Entry));
+		bRegressed |= Result.bRegressed;
+	}
+	Root->SetBoolField(TEXT("Regressed"), bRegressed);
+	Root->SetArrayField(TEXT("Results"), Entries);
+
+	FString Json;
+	FJsonSerializer::Serialize(Root, TJsonWriterFactory<>::Create(&Json));
+	return Json;
+}
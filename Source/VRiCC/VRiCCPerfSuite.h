@@ -0,0 +1,124 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCPerfSuite.generated.h"
+
+class AVRiCCCharacter;
+
+/** Hot path a perf suite run drives */
+enum class EVRiCCPerfScenario : uint8
+{
+	/** Every shooter fires a hitscan shot each frame */
+	Fire,
+	/** Every shooter launches a projectile every few frames */
+	Projectiles,
+	/** Every shooter walks into a weapon pickup */
+	Pickups,
+	/** Every character takes a hit each frame */
+	Damage,
+};
+
+/** Numbers of one scenario at one scale */
+struct FVRiCCPerfResult
+{
+	EVRiCCPerfScenario Scenario = EVRiCCPerfScenario::Fire;
+	int32 NumActors = 0;
+	int32 NumFrames = 0;
+	/** Whole game thread frame, without idle time */
+	float FrameMsAvg = 0.f;
+	float FrameMsP95 = 0.f;
+	/** Only the calls into the scenario's hot path */
+	float WorkMsAvg = 0.f;
+	float WorkMsP95 = 0.f;
+	/** From the baseline, negative if the baseline has no entry for this run */
+	float BaselineFrameMsAvg = -1.f;
+	float BaselineWorkMsAvg = -1.f;
+	bool bRegressed = false;
+};
+
+/**
+ * Scripted performance suite, started with -VRiCCPerfSuite or VRiCC.PerfSuite.Run on a standalone or server world.
+ * For each scale of -VRiCCPerfScales (default 1,16,64,256) it spawns that many AVRiCCCharacter shooters, runs every
+ * scenario for VRiCC.PerfSuite.WarmupFrames then measures VRiCC.PerfSuite.MeasureFrames, and writes the results
+ * as JSON to Saved/Perf/. Runs slower than the baseline (-VRiCCPerfBaseline, default Saved/Perf/Baseline.json)
+ * by more than VRiCC.PerfSuite.Threshold count as regressions, and a command line run exits with status 1.
+ * Scripts/RunPerfSuite.sh runs it headless with -nullrhi -unattended.
+ */
+UCLASS()
+class VRICC_API UVRiCCPerfSuiteSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// End of UWorldSubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bRunning; }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Queues every scenario at every scale, bExitWhenDone quits with the regression status at the end */
+	void StartSuite(TConstArrayView<int32> Scales, bool bExitWhenDone);
+
+	bool IsRunning() const { return bRunning; }
+
+	static const TCHAR* GetScenarioName(EVRiCCPerfScenario Scenario);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FRun
+	{
+		EVRiCCPerfScenario Scenario;
+		int32 NumActors;
+	};
+
+	/** Spawns the shooters and props of the current run */
+	bool SetUpRun(const FRun& Run);
+	void TearDownRun();
+
+	/** Drives one frame of the current run, returns the milliseconds spent in its hot path */
+	double DriveFrame(const FRun& Run, int32 Frame);
+
+	AVRiCCCharacter* SpawnShooter(const FVector& Location);
+	AActor* SpawnWeapon(const FVector& Location);
+	FVector GetSlotLocation(int32 Index) const;
+
+	void FinishRun(const FRun& Run);
+	void FinishSuite();
+
+	/** Fills the baseline numbers of Results, returns true if any run regressed */
+	bool CompareWithBaseline(const FString& BaselinePath);
+	FString ToJson() const;
+
+	TArray<FRun> Runs;
+	int32 RunIndex = 0;
+	int32 RunFrame = 0;
+
+	TArray<TWeakObjectPtr<AVRiCCCharacter>> Shooters;
+	TArray<TWeakObjectPtr<AActor>> Props;
+
+	UPROPERTY(Transient)
+	TObjectPtr<UClass> ShooterClass;
+	UPROPERTY(Transient)
+	TObjectPtr<UClass> WeaponClass;
+	UPROPERTY(Transient)
+	TObjectPtr<UClass> ProjectileClass;
+
+	FVector Origin = FVector::ZeroVector;
+
+	TArray<float> FrameMs;
+	TArray<float> WorkMs;
+
+	TArray<FVRiCCPerfResult> Results;
+
+	bool bRunning = false;
+	bool bExitWhenDone = false;
+};
@@ -2,7 +2,11 @@
 
 
 #include "VRiCCPlayerController.h"
+#include "VRiCCAssetManager.h"
+#include "VRiCCBotComponent.h"
+#include "VRiCCInputRecorder.h"
 #include "EnhancedInputSubsystems.h"
+#include "Misc/CommandLine.h"
 
 void AVRiCCPlayerController::BeginPlay()
 {
@@ -16,4 +20,49 @@ void AVRiCCPlayerController::BeginPlay()
 
 		UE_LOG(LogTemp, Warning, TEXT("BeginPlay"));
 	}
-}
\ No newline at end of file
+
+	// load test clients play themselves
+	if (IsLocalController() && FParse::Param(FCommandLine::Get(), TEXT("VRiCCBot")))
+	{
+		UVRiCCBotComponent* Bot = NewObject<UVRiCCBotComponent>(this, TEXT("Bot"));
+		Bot->ConfigureFromCommandLine();
+		Bot->RegisterComponent();
+	}
+
+	// captured firefights are recorded and replayed on the local player
+	if (IsLocalController() && (FParse::Param(FCommandLine::Get(), TEXT("VRiCCRecordInput")) || FParse::Param(FCommandLine::Get(), TEXT("VRiCCReplayInput"))))
+	{
+		GetInputRecorder()->ConfigureFromCommandLine();
+	}
+}
+
+UVRiCCInputRecorderComponent* AVRiCCPlayerController::GetInputRecorder()
+{
+	if (InputRecorder == nullptr && IsLocalController())
+	{
+		InputRecorder = NewObject<UVRiCCInputRecorderComponent>(this, TEXT("InputRecorder"));
+		InputRecorder->RegisterComponent();
+	}
+	return InputRecorder;
+}
+
+void AVRiCCPlayerController::PlayerTick(float DeltaTime)
+{
+	// before the input is processed, so recorded and replayed actions reach the pawn in the same place of the frame
+	if (InputRecorder != nullptr)
+	{
+		InputRecorder->BeginInputFrame(DeltaTime);
+	}
+
+	// the first frame the local player controls a pawn ends the startup timing
+	if (!bStartupTimed && GetPawn() != nullptr)
+	{
+		bStartupTimed = true;
+		if (UVRiCCAssetManager* AssetManager = UVRiCCAssetManager::Get())
+		{
+			AssetManager->MarkPlayable();
+		}
+	}
+
+	Super::PlayerTick(DeltaTime);
+}
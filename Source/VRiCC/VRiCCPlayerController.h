@@ -7,6 +7,7 @@
 #include "VRiCCPlayerController.generated.h"
 
 class UInputMappingContext;
+class UVRiCCInputRecorderComponent;
 
 /**
  *
@@ -16,6 +17,12 @@ class VRICC_API AVRiCCPlayerController : public APlayerController
 {
 	GENERATED_BODY()
 	
+public:
+	/** Records or replays this controller's input, created on first use */
+	UVRiCCInputRecorderComponent* GetInputRecorder();
+
+	virtual void PlayerTick(float DeltaTime) override;
+
 protected:
 
 	/** Input Mapping Context to be used for player input */
@@ -28,4 +35,10 @@ protected:
 	virtual void BeginPlay() override;
 
 	// End Actor interface
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<UVRiCCInputRecorderComponent> InputRecorder;
+
+	bool bStartupTimed = false;
 };
@@ -1,8 +1,11 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "VRiCCProjectile.h"
+#include "VRiCC.h"
+#include "VRiCCProjectilePool.h"
 #include "GameFramework/ProjectileMovementComponent.h"
 #include "Components/SphereComponent.h"
+#include "TimerManager.h"
 
 AVRiCCProjectile::AVRiCCProjectile() 
 {
@@ -27,17 +30,90 @@ AVRiCCProjectile::AVRiCCProjectile()
 	ProjectileMovement->bRotationFollowsVelocity = true;
 	ProjectileMovement->bShouldBounce = true;
 
-	// Die after 3 seconds by default
-	InitialLifeSpan = 3.0f;
+	// Die after 3 seconds by default, expiry is a timer so pooled instances can be recycled instead
+	ProjectileLifeSpan = 3.0f;
+
+	bPooled = false;
+	bProjectileActive = true;
+}
+
+void AVRiCCProjectile::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// pooled instances start their life span when they are launched
+	if (!bPooled)
+	{
+		GetWorldTimerManager().SetTimer(LifeSpanTimerHandle, this, &AVRiCCProjectile::Expire, ProjectileLifeSpan, false);
+	}
+}
+
+void AVRiCCProjectile::ActivateProjectile(const FTransform& Transform)
+{
+	bProjectileActive = true;
+
+	SetActorLocationAndRotation(Transform.GetLocation(), Transform.GetRotation(), false, nullptr, ETeleportType::ResetPhysics);
+	SetActorHiddenInGame(false);
+	SetActorEnableCollision(true);
+
+	// the movement component drops its updated component when it stops simulating
+	ProjectileMovement->SetUpdatedComponent(CollisionComp);
+	ProjectileMovement->Velocity = Transform.GetRotation().Vector() * ProjectileMovement->InitialSpeed;
+	ProjectileMovement->Activate(true);
+
+	GetWorldTimerManager().SetTimer(LifeSpanTimerHandle, this, &AVRiCCProjectile::Expire, ProjectileLifeSpan, false);
+}
+
+void AVRiCCProjectile::DeactivateProjectile()
+{
+	bProjectileActive = false;
+
+	GetWorldTimerManager().ClearTimer(LifeSpanTimerHandle);
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	SetActorEnableCollision(false);
+	SetActorHiddenInGame(true);
+}
+
+void AVRiCCProjectile::BecomeVisualProxy()
+{
+	// the manager decides when it expires
+	GetWorldTimerManager().ClearTimer(LifeSpanTimerHandle);
+
+	ProjectileMovement->StopMovementImmediately();
+	ProjectileMovement->Deactivate();
+	SetActorEnableCollision(false);
+}
+
+void AVRiCCProjectile::Expire()
+{
+	if (bPooled)
+	{
+		if (UVRiCCProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UVRiCCProjectilePoolSubsystem>())
+		{
+			ProjectilePool->Release(this);
+			return;
+		}
+	}
+
+	Destroy();
 }
 
 void AVRiCCProjectile::OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
 {
-	// Only add impulse and destroy projectile if we hit a physics
+#if VRICC_WITH_PRESENTATION
+	if (UVRiCCImpactEffectsSubsystem* ImpactFX = GetWorld()->GetSubsystem<UVRiCCImpactEffectsSubsystem>())
+	{
+		ImpactFX->QueueImpact(ImpactEffects, Hit.ImpactPoint, Hit.ImpactNormal, OtherComp == nullptr || OtherComp->Mobility != EComponentMobility::Movable);
+	}
+#endif
+
+	// Only add impulse and expire projectile if we hit a physics
 	if ((OtherActor != nullptr) && (OtherActor != this) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
 	{
 		OtherComp->AddImpulseAtLocation(GetVelocity() * 100.0f, GetActorLocation());
 
-		Destroy();
+		Expire();
 	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "VRiCCImpactEffects.h"
 #include "VRiCCProjectile.generated.h"
 
 class USphereComponent;
@@ -29,9 +30,42 @@ public:
 	UFUNCTION()
 	void OnHit(UPrimitiveComponent* HitComp, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
 
+	/** Particles and decal left wherever the projectile hits or bounces */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	FVRiCCImpactEffectSet ImpactEffects;
+
+	/** Seconds a launched projectile lives before it expires */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Projectile)
+	float ProjectileLifeSpan;
+
+	/** Launches the projectile from Transform, used by the projectile pool to reuse this instance */
+	void ActivateProjectile(const FTransform& Transform);
+
+	/** Stops, hides and disables collision so the instance can wait in the pool */
+	void DeactivateProjectile();
+
+	/** Stops movement and collision so the projectile manager can drive this actor as a visual only */
+	void BecomeVisualProxy();
+
+	/** Returns to the pool if it came from one, destroys it otherwise */
+	void Expire();
+
+	void SetPooled(bool bNewPooled) { bPooled = bNewPooled; }
+	bool IsProjectileActive() const { return bProjectileActive; }
+
 	/** Returns CollisionComp subobject **/
 	USphereComponent* GetCollisionComp() const { return CollisionComp; }
 	/** Returns ProjectileMovement subobject **/
 	UProjectileMovementComponent* GetProjectileMovement() const { return ProjectileMovement; }
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	FTimerHandle LifeSpanTimerHandle;
+
+	/** Owned by the projectile pool rather than destroyed on expiry */
+	bool bPooled;
+	bool bProjectileActive;
 };
 
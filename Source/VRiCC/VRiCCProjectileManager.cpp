@@ -0,0 +1,503 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCProjectileManager.h"
+#include "VRiCC.h"
+#include "VRiCCProjectile.h"
+#include "VRiCCProjectilePool.h"
+#include "VRiCCStats.h"
+#include "Async/ParallelFor.h"
+#include "Components/SphereComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/ProjectileMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarSimulateProjectiles(
+	TEXT("VRiCC.Projectiles.Simulate"),
+	true,
+	TEXT("Simulate weapon projectiles in the data oriented projectile manager instead of one actor with a movement component each."));
+
+static TAutoConsoleVariable<bool> CVarProjectileVisualProxies(
+	TEXT("VRiCC.Projectiles.VisualProxies"),
+	true,
+	TEXT("Attach a pooled AVRiCCProjectile to every simulated projectile so it can be seen. Never used on dedicated servers."));
+
+static TAutoConsoleVariable<int32> CVarProjectileSweepBatchSize(
+	TEXT("VRiCC.Projectiles.SweepBatchSize"),
+	64,
+	TEXT("Number of projectiles swept per parallel collision batch."));
+
+static FAutoConsoleCommandWithWorld GProjectileStatsCommand(
+	TEXT("VRiCC.Projectiles.Stats"),
+	TEXT("Prints the projectile manager counters."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCProjectileManager* ProjectileManager = World != nullptr ? World->GetSubsystem<UVRiCCProjectileManager>() : nullptr)
+		{
+			const FVRiCCProjectileManagerStats& Stats = ProjectileManager->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("Projectiles: alive %d, peak %d, hits last frame %d, integrate %.3fms, sweep %.3fms, resolve %.3fms"),
+				Stats.NumAlive, Stats.PeakAlive, Stats.HitsLastFrame, Stats.IntegrateMs, Stats.SweepMs, Stats.ResolveMs);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorldAndArgs GProjectileBenchmarkCommand(
+	TEXT("VRiCC.Projectiles.Benchmark"),
+	TEXT("VRiCC.Projectiles.Benchmark [NumProjectiles=10000] [NumFrames=60]: measures how many projectiles the manager simulates per millisecond."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UVRiCCProjectileManager* ProjectileManager = World != nullptr ? World->GetSubsystem<UVRiCCProjectileManager>() : nullptr)
+		{
+			const int32 NumProjectiles = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000;
+			const int32 NumFrames = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 60;
+			ProjectileManager->RunBenchmark(FMath::Max(NumProjectiles, 1), FMath::Max(NumFrames, 1));
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// FVRiCCProjectileSoA
+
+// every float array, so adding a field only needs one more line here
+#define VRICC_PROJECTILE_FLOAT_ARRAYS(Op) \
+	Op(PositionX) Op(PositionY) Op(PositionZ) \
+	Op(VelocityX) Op(VelocityY) Op(VelocityZ) \
+	Op(GravityZ) Op(Lifetime) \
+	Op(PreviousX) Op(PreviousY) Op(PreviousZ)
+
+void FVRiCCProjectileSoA::Reserve(int32 Capacity)
+{
+	const int32 Padded = Align(Capacity, 4);
+#define VRICC_RESERVE(Array) Array.Reserve(Padded);
+	VRICC_PROJECTILE_FLOAT_ARRAYS(VRICC_RESERVE)
+#undef VRICC_RESERVE
+	Type.Reserve(Capacity);
+	Owner.Reserve(Capacity);
+	Proxy.Reserve(Capacity);
+}
+
+void FVRiCCProjectileSoA::SetNumPadded(int32 NewCount)
+{
+	// padding lanes stay zeroed so the kernel can always run full 4 wide iterations
+	const int32 Padded = Align(NewCount, 4);
+	if (PositionX.Num() < Padded)
+	{
+#define VRICC_GROW(Array) Array.SetNumZeroed(Padded);
+		VRICC_PROJECTILE_FLOAT_ARRAYS(VRICC_GROW)
+#undef VRICC_GROW
+	}
+	Count = NewCount;
+}
+
+int32 FVRiCCProjectileSoA::Add(const FVector& Position, const FVector& Velocity, float InGravityZ, float InLifetime, uint16 InType, AActor* InOwner)
+{
+	const int32 Index = Count;
+	SetNumPadded(Count + 1);
+
+	SetPosition(Index, Position);
+	SetVelocity(Index, Velocity);
+	PreviousX[Index] = PositionX[Index];
+	PreviousY[Index] = PositionY[Index];
+	PreviousZ[Index] = PositionZ[Index];
+	GravityZ[Index] = InGravityZ;
+	Lifetime[Index] = InLifetime;
+
+	Type.Add(InType);
+	Owner.Add(InOwner);
+	Proxy.AddDefaulted();
+	return Index;
+}
+
+void FVRiCCProjectileSoA::RemoveAtSwap(int32 Index)
+{
+	check(Index >= 0 && Index < Count);
+
+	const int32 Last = Count - 1;
+#define VRICC_SWAP_REMOVE(Array) Array[Index] = Array[Last]; Array[Last] = 0.f;
+	VRICC_PROJECTILE_FLOAT_ARRAYS(VRICC_SWAP_REMOVE)
+#undef VRICC_SWAP_REMOVE
+
+	Type.RemoveAtSwap(Index, 1, false);
+	Owner.RemoveAtSwap(Index, 1, false);
+	Proxy.RemoveAtSwap(Index, 1, false);
+	Count = Last;
+}
+
+void FVRiCCProjectileSoA::Reset()
+{
+#define VRICC_RESET(Array) Array.Reset();
+	VRICC_PROJECTILE_FLOAT_ARRAYS(VRICC_RESET)
+#undef VRICC_RESET
+	Type.Reset();
+	Owner.Reset();
+	Proxy.Reset();
+	Count = 0;
+}
+
+#undef VRICC_PROJECTILE_FLOAT_ARRAYS
+
+void FVRiCCProjectileSoA::SetPosition(int32 Index, const FVector& Position)
+{
+	PositionX[Index] = float(Position.X);
+	PositionY[Index] = float(Position.Y);
+	PositionZ[Index] = float(Position.Z);
+}
+
+void FVRiCCProjectileSoA::SetVelocity(int32 Index, const FVector& Velocity)
+{
+	VelocityX[Index] = float(Velocity.X);
+	VelocityY[Index] = float(Velocity.Y);
+	VelocityZ[Index] = float(Velocity.Z);
+}
+
+void FVRiCCProjectileSoA::Integrate(float DeltaTime)
+{
+	const int32 PaddedNum = Align(Count, 4);
+	if (PaddedNum == 0)
+	{
+		return;
+	}
+
+	FMemory::Memcpy(PreviousX.GetData(), PositionX.GetData(), PaddedNum * sizeof(float));
+	FMemory::Memcpy(PreviousY.GetData(), PositionY.GetData(), PaddedNum * sizeof(float));
+	FMemory::Memcpy(PreviousZ.GetData(), PositionZ.GetData(), PaddedNum * sizeof(float));
+
+	float* RESTRICT PX = PositionX.GetData();
+	float* RESTRICT PY = PositionY.GetData();
+	float* RESTRICT PZ = PositionZ.GetData();
+	const float* RESTRICT VX = VelocityX.GetData();
+	const float* RESTRICT VY = VelocityY.GetData();
+	float* RESTRICT VZ = VelocityZ.GetData();
+	const float* RESTRICT GZ = GravityZ.GetData();
+	float* RESTRICT Life = Lifetime.GetData();
+
+	const VectorRegister4Float Dt = VectorSetFloat1(DeltaTime);
+	const VectorRegister4Float HalfDt = VectorSetFloat1(DeltaTime * 0.5f);
+
+	// gravity only acts on Z; position uses the average of old and new velocity like UProjectileMovementComponent
+	for (int32 Index = 0; Index < PaddedNum; Index += 4)
+	{
+		const VectorRegister4Float OldVZ = VectorLoadAligned(VZ + Index);
+		const VectorRegister4Float NewVZ = VectorMultiplyAdd(VectorLoadAligned(GZ + Index), Dt, OldVZ);
+
+		VectorStoreAligned(VectorMultiplyAdd(VectorLoadAligned(VX + Index), Dt, VectorLoadAligned(PX + Index)), PX + Index);
+		VectorStoreAligned(VectorMultiplyAdd(VectorLoadAligned(VY + Index), Dt, VectorLoadAligned(PY + Index)), PY + Index);
+		VectorStoreAligned(VectorMultiplyAdd(VectorAdd(OldVZ, NewVZ), HalfDt, VectorLoadAligned(PZ + Index)), PZ + Index);
+		VectorStoreAligned(NewVZ, VZ + Index);
+		VectorStoreAligned(VectorSubtract(VectorLoadAligned(Life + Index), Dt), Life + Index);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UVRiCCProjectileManager
+
+bool UVRiCCProjectileManager::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UVRiCCProjectileManager::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCProjectileManager, STATGROUP_Tickables);
+}
+
+bool UVRiCCProjectileManager::IsSimulationEnabled()
+{
+	return CVarSimulateProjectiles.GetValueOnGameThread();
+}
+
+void UVRiCCProjectileManager::Deinitialize()
+{
+	Projectiles.Reset();
+	Super::Deinitialize();
+}
+
+uint16 UVRiCCProjectileManager::FindOrAddType(UClass* ProjectileClass)
+{
+	for (int32 Index = 0; Index < Types.Num(); ++Index)
+	{
+		if (Types[Index].Class == ProjectileClass)
+		{
+			return uint16(Index);
+		}
+	}
+
+	// tuning comes from the same components the actor based projectile would use
+	FVRiCCProjectileType& NewType = Types.AddDefaulted_GetRef();
+	NewType.Class = ProjectileClass;
+	if (const AVRiCCProjectile* Defaults = ProjectileClass->GetDefaultObject<AVRiCCProjectile>())
+	{
+		if (const UProjectileMovementComponent* Movement = Defaults->GetProjectileMovement())
+		{
+			NewType.InitialSpeed = Movement->InitialSpeed;
+			NewType.MaxSpeed = Movement->MaxSpeed;
+			NewType.GravityScale = Movement->ProjectileGravityScale;
+			NewType.Bounciness = Movement->Bounciness;
+			NewType.Friction = Movement->Friction;
+			NewType.BounceStopSpeed = Movement->BounceVelocityStopSimulatingThreshold;
+		}
+		if (const USphereComponent* Collision = Defaults->GetCollisionComp())
+		{
+			NewType.Radius = Collision->GetUnscaledSphereRadius();
+		}
+		NewType.LifeSpan = Defaults->ProjectileLifeSpan;
+		NewType.ImpactEffects = Defaults->ImpactEffects;
+	}
+	return uint16(Types.Num() - 1);
+}
+
+void UVRiCCProjectileManager::SpawnProjectile(TSubclassOf<AVRiCCProjectile> ProjectileClass, const FVector& Location, const FVector& Direction, AActor* Owner)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	const uint16 TypeIndex = FindOrAddType(ProjectileClass);
+	const FVRiCCProjectileType& ProjectileType = Types[TypeIndex];
+	const float Speed = ProjectileType.MaxSpeed > 0.f ? FMath::Min(ProjectileType.InitialSpeed, ProjectileType.MaxSpeed) : ProjectileType.InitialSpeed;
+	const float GravityZ = GetWorld()->GetGravityZ() * ProjectileType.GravityScale;
+
+	const int32 Index = Projectiles.Add(Location, Direction.GetSafeNormal() * Speed, GravityZ, ProjectileType.LifeSpan, TypeIndex, Owner);
+
+	// the actor is only a visual, collision and movement stay in the manager
+	if (CVarProjectileVisualProxies.GetValueOnGameThread() && VRiCC::IsPresentationEnabled(this))
+	{
+		if (UVRiCCProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UVRiCCProjectilePoolSubsystem>())
+		{
+			if (AVRiCCProjectile* Proxy = ProjectilePool->Acquire(ProjectileClass, FTransform(Direction.Rotation(), Location), Owner, Cast<APawn>(Owner)))
+			{
+				Proxy->BecomeVisualProxy();
+				Projectiles.Proxy[Index] = Proxy;
+			}
+		}
+	}
+
+	Stats.NumAlive = Projectiles.Num();
+	Stats.PeakAlive = FMath::Max(Stats.PeakAlive, Stats.NumAlive);
+}
+
+void UVRiCCProjectileManager::Tick(float DeltaTime)
+{
+	VRICC_SET(ProjectilesAlive, Projectiles.Num());
+	if (Projectiles.Num() == 0)
+	{
+		return;
+	}
+
+	VRICC_SCOPE_CYCLE(Projectiles);
+
+	Simulate(Projectiles, DeltaTime);
+	UpdateProxies();
+
+	Stats.NumAlive = Projectiles.Num();
+}
+
+void UVRiCCProjectileManager::Simulate(FVRiCCProjectileSoA& Data, float DeltaTime)
+{
+	const double StartSeconds = FPlatformTime::Seconds();
+	Data.Integrate(DeltaTime);
+
+	const double IntegratedSeconds = FPlatformTime::Seconds();
+	SweepBatches(Data);
+
+	const double SweptSeconds = FPlatformTime::Seconds();
+	ResolveHits(Data);
+
+	const double ResolvedSeconds = FPlatformTime::Seconds();
+	Stats.IntegrateMs = (IntegratedSeconds - StartSeconds) * 1000.0;
+	Stats.SweepMs = (SweptSeconds - IntegratedSeconds) * 1000.0;
+	Stats.ResolveMs = (ResolvedSeconds - SweptSeconds) * 1000.0;
+}
+
+void UVRiCCProjectileManager::SweepBatches(const FVRiCCProjectileSoA& Data)
+{
+	static const FName ProjectileProfile(TEXT("Projectile"));
+
+	const int32 Num = Data.Num();
+	SweepHits.SetNum(Num, false);
+	SweepHitFlags.SetNumUninitialized(Num, false);
+
+	// resolve weak owners on the game thread, workers only see raw pointers
+	SweepIgnoreActors.SetNumUninitialized(Num, false);
+	for (int32 Index = 0; Index < Num; ++Index)
+	{
+		SweepIgnoreActors[Index] = Data.Owner[Index].Get();
+	}
+
+	const UWorld* World = GetWorld();
+	const int32 BatchSize = FMath::Max(CVarProjectileSweepBatchSize.GetValueOnGameThread(), 1);
+	const int32 NumBatches = FMath::DivideAndRoundUp(Num, BatchSize);
+
+	ParallelFor(NumBatches, [this, &Data, World, BatchSize, Num](int32 BatchIndex)
+	{
+		const int32 First = BatchIndex * BatchSize;
+		const int32 Last = FMath::Min(First + BatchSize, Num);
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			const FVector Start = Data.GetPreviousPosition(Index);
+			const FVector End = Data.GetPosition(Index);
+
+			// resting projectiles only wait for their life span to run out
+			if (FVector::DistSquared(Start, End) < UE_KINDA_SMALL_NUMBER)
+			{
+				SweepHitFlags[Index] = 0;
+				continue;
+			}
+
+			const FCollisionQueryParams Params(SCENE_QUERY_STAT(VRiCCProjectileSweep), false, SweepIgnoreActors[Index]);
+			const FCollisionShape Shape = FCollisionShape::MakeSphere(Types[Data.Type[Index]].Radius);
+			SweepHitFlags[Index] = World->SweepSingleByProfile(SweepHits[Index], Start, End, FQuat::Identity, ProjectileProfile, Shape, Params) ? 1 : 0;
+		}
+	});
+}
+
+/** Reflects Velocity off a surface the way UProjectileMovementComponent::ComputeBounceDelta does */
+static FVector ComputeBounceVelocity(const FVector& Velocity, const FVector& Normal, const FVRiCCProjectileType& ProjectileType)
+{
+	const double VDotNormal = FVector::DotProduct(Velocity, Normal);
+	if (VDotNormal > 0.0)
+	{
+		return Velocity;
+	}
+
+	// tangential part keeps its direction and loses some speed to friction, the normal part is restituted
+	const FVector ProjectedNormal = Normal * -VDotNormal;
+	FVector Bounced = (Velocity + ProjectedNormal) * FMath::Clamp(1.f - ProjectileType.Friction, 0.f, 1.f);
+	Bounced += ProjectedNormal * FMath::Max(ProjectileType.Bounciness, 0.f);
+
+	if (ProjectileType.MaxSpeed > 0.f)
+	{
+		Bounced = Bounced.GetClampedToMaxSize(ProjectileType.MaxSpeed);
+	}
+	return Bounced;
+}
+
+void UVRiCCProjectileManager::ResolveHits(FVRiCCProjectileSoA& Data)
+{
+#if VRICC_WITH_PRESENTATION
+	UVRiCCImpactEffectsSubsystem* ImpactFX = GetWorld()->GetSubsystem<UVRiCCImpactEffectsSubsystem>();
+#endif
+
+	// walk backwards so swap removal only moves projectiles that were already handled
+	int32 NumHits = 0;
+	for (int32 Index = Data.Num() - 1; Index >= 0; --Index)
+	{
+		if (SweepHitFlags[Index] != 0)
+		{
+			NumHits++;
+
+			const FHitResult& Hit = SweepHits[Index];
+			const FVector Velocity = Data.GetVelocity(Index);
+			UPrimitiveComponent* OtherComp = Hit.GetComponent();
+
+#if VRICC_WITH_PRESENTATION
+			if (ImpactFX != nullptr)
+			{
+				ImpactFX->QueueImpact(Types[Data.Type[Index]].ImpactEffects, Hit.ImpactPoint, Hit.ImpactNormal, OtherComp == nullptr || OtherComp->Mobility != EComponentMobility::Movable);
+			}
+#endif
+
+			// Only add impulse and expire projectile if we hit a physics, same as AVRiCCProjectile::OnHit
+			if ((Hit.GetActor() != nullptr) && (OtherComp != nullptr) && OtherComp->IsSimulatingPhysics())
+			{
+				OtherComp->AddImpulseAtLocation(Velocity * 100.0f, Hit.Location);
+				RemoveProjectile(Data, Index);
+				continue;
+			}
+
+			// anything else is bounced off, the rest of this frame's movement is dropped
+			const FVRiCCProjectileType& ProjectileType = Types[Data.Type[Index]];
+			const FVector Bounced = ComputeBounceVelocity(Velocity, Hit.Normal, ProjectileType);
+			Data.SetPosition(Index, Hit.Location + Hit.Normal * 0.1);
+
+			if (Bounced.SizeSquared() < FMath::Square(ProjectileType.BounceStopSpeed))
+			{
+				// too slow to keep bouncing, rest where it landed
+				Data.SetVelocity(Index, FVector::ZeroVector);
+				Data.GravityZ[Index] = 0.f;
+			}
+			else
+			{
+				Data.SetVelocity(Index, Bounced);
+			}
+		}
+
+		if (Data.Lifetime[Index] <= 0.f)
+		{
+			RemoveProjectile(Data, Index);
+		}
+	}
+
+	Stats.HitsLastFrame = NumHits;
+}
+
+void UVRiCCProjectileManager::RemoveProjectile(FVRiCCProjectileSoA& Data, int32 Index)
+{
+	if (AVRiCCProjectile* Proxy = Data.Proxy[Index].Get())
+	{
+		Proxy->Expire();
+	}
+	Data.RemoveAtSwap(Index);
+}
+
+void UVRiCCProjectileManager::RemoveAllProjectiles()
+{
+	for (int32 Index = Projectiles.Num() - 1; Index >= 0; --Index)
+	{
+		RemoveProjectile(Projectiles, Index);
+	}
+	Stats.NumAlive = 0;
+}
+
+void UVRiCCProjectileManager::UpdateProxies()
+{
+	for (int32 Index = 0; Index < Projectiles.Num(); ++Index)
+	{
+		if (AVRiCCProjectile* Proxy = Projectiles.Proxy[Index].Get())
+		{
+			// rotation follows velocity, resting projectiles keep their last rotation
+			const FVector Velocity = Projectiles.GetVelocity(Index);
+			const FRotator Rotation = Velocity.IsNearlyZero() ? Proxy->GetActorRotation() : Velocity.Rotation();
+			Proxy->SetActorLocationAndRotation(Projectiles.GetPosition(Index), Rotation);
+		}
+	}
+}
+
+void UVRiCCProjectileManager::RunBenchmark(int32 NumProjectiles, int32 NumFrames)
+{
+	// separate data far above the level, so the running game is not disturbed and sweeps find nothing to hit
+	FVRiCCProjectileSoA Data;
+	Data.Reserve(NumProjectiles);
+
+	const uint16 TypeIndex = FindOrAddType(AVRiCCProjectile::StaticClass());
+	const float GravityZ = GetWorld()->GetGravityZ();
+	FRandomStream Random(NumProjectiles);
+	for (int32 Index = 0; Index < NumProjectiles; ++Index)
+	{
+		const FVector Position(Random.FRandRange(-100000.f, 100000.f), Random.FRandRange(-100000.f, 100000.f), 1000000.f + Random.FRandRange(0.f, 10000.f));
+		Data.Add(Position, Random.GetUnitVector() * Types[TypeIndex].InitialSpeed, GravityZ, UE_BIG_NUMBER, TypeIndex, nullptr);
+	}
+
+	const FVRiCCProjectileManagerStats SavedStats = Stats;
+	const float DeltaTime = 1.f / 60.f;
+
+	double StartSeconds = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		Data.Integrate(DeltaTime);
+	}
+	const double IntegrateMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0 / NumFrames;
+
+	StartSeconds = FPlatformTime::Seconds();
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		Simulate(Data, DeltaTime);
+	}
+	const double SimulateMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0 / NumFrames;
+
+	Stats = SavedStats;
+
+	// thousands of projectiles advanced per millisecond of game thread time
+	UE_LOG(LogTemp, Display, TEXT("Projectile benchmark, %d projectiles x %d frames: integrate %.3fms/frame (%.1fk/ms), integrate+sweep+resolve %.3fms/frame (%.1fk/ms)"),
+		NumProjectiles, NumFrames,
+		IntegrateMs, NumProjectiles / FMath::Max(IntegrateMs, UE_SMALL_NUMBER) / 1000.0,
+		SimulateMs, NumProjectiles / FMath::Max(SimulateMs, UE_SMALL_NUMBER) / 1000.0);
+}
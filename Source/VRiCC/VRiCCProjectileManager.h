@@ -0,0 +1,154 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCImpactEffects.h"
+#include "VRiCCProjectileManager.generated.h"
+
+class AVRiCCProjectile;
+
+/** Tuning shared by every simulated projectile of one class, read from the class defaults */
+USTRUCT()
+struct FVRiCCProjectileType
+{
+	GENERATED_BODY()
+
+	UPROPERTY(Transient)
+	TObjectPtr<UClass> Class = nullptr;
+
+	float InitialSpeed = 3000.f;
+	float MaxSpeed = 3000.f;
+	float GravityScale = 1.f;
+	float Radius = 5.f;
+	float Bounciness = 0.6f;
+	float Friction = 0.2f;
+	float BounceStopSpeed = 5.f;
+	float LifeSpan = 3.f;
+
+	UPROPERTY(Transient)
+	FVRiCCImpactEffectSet ImpactEffects;
+};
+
+/**
+ * Projectile state in structure of arrays form.
+ * The float arrays are padded to a multiple of 4 and 16 byte aligned so the integration kernel runs 4 wide.
+ */
+struct VRICC_API FVRiCCProjectileSoA
+{
+	template<typename T>
+	using TSimdArray = TArray<T, TAlignedHeapAllocator<16>>;
+
+	TSimdArray<float> PositionX;
+	TSimdArray<float> PositionY;
+	TSimdArray<float> PositionZ;
+	TSimdArray<float> VelocityX;
+	TSimdArray<float> VelocityY;
+	TSimdArray<float> VelocityZ;
+	TSimdArray<float> GravityZ;
+	TSimdArray<float> Lifetime;
+
+	/** Positions before the last Integrate, the start of this frame's collision sweep */
+	TSimdArray<float> PreviousX;
+	TSimdArray<float> PreviousY;
+	TSimdArray<float> PreviousZ;
+
+	TArray<uint16> Type;
+	TArray<TWeakObjectPtr<AActor>> Owner;
+	TArray<TWeakObjectPtr<AVRiCCProjectile>> Proxy;
+
+	int32 Num() const { return Count; }
+
+	void Reserve(int32 Capacity);
+	int32 Add(const FVector& Position, const FVector& Velocity, float InGravityZ, float InLifetime, uint16 InType, AActor* InOwner);
+	void RemoveAtSwap(int32 Index);
+	void Reset();
+
+	FVector GetPosition(int32 Index) const { return FVector(PositionX[Index], PositionY[Index], PositionZ[Index]); }
+	FVector GetPreviousPosition(int32 Index) const { return FVector(PreviousX[Index], PreviousY[Index], PreviousZ[Index]); }
+	FVector GetVelocity(int32 Index) const { return FVector(VelocityX[Index], VelocityY[Index], VelocityZ[Index]); }
+	void SetPosition(int32 Index, const FVector& Position);
+	void SetVelocity(int32 Index, const FVector& Velocity);
+
+	/** Advances every projectile by DeltaTime with constant acceleration, 4 projectiles per iteration */
+	void Integrate(float DeltaTime);
+
+private:
+	void SetNumPadded(int32 NewCount);
+
+	int32 Count = 0;
+};
+
+/** Counters of the projectile manager, timings are for the last simulated frame */
+struct FVRiCCProjectileManagerStats
+{
+	int32 NumAlive = 0;
+	int32 PeakAlive = 0;
+	int32 HitsLastFrame = 0;
+	double IntegrateMs = 0.0;
+	double SweepMs = 0.0;
+	double ResolveMs = 0.0;
+};
+
+/**
+ * Simulates projectiles as plain data instead of one actor and movement component each.
+ * Movement is integrated with a SIMD kernel, collision is swept in parallel batches and hits are
+ * resolved serially with the bounce and physics impulse behaviour of AVRiCCProjectile::OnHit.
+ * AVRiCCProjectile instances from the projectile pool are only used as optional visual proxies.
+ */
+UCLASS()
+class VRICC_API UVRiCCProjectileManager : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	virtual void Deinitialize() override;
+
+	/** False when VRiCC.Projectiles.Simulate is off and weapons should launch projectile actors instead */
+	static bool IsSimulationEnabled();
+
+	/** Launches a simulated projectile of ProjectileClass from Location along Direction */
+	void SpawnProjectile(TSubclassOf<AVRiCCProjectile> ProjectileClass, const FVector& Location, const FVector& Direction, AActor* Owner);
+
+	/** Expires every simulated projectile and its proxy */
+	void RemoveAllProjectiles();
+
+	/** Advances Data by DeltaTime: integrate, sweep and resolve hits. Proxies are only moved for the manager's own data */
+	void Simulate(FVRiCCProjectileSoA& Data, float DeltaTime);
+
+	const FVRiCCProjectileManagerStats& GetStats() const { return Stats; }
+
+	/** Runs the simulation on NumProjectiles synthetic projectiles far from any geometry and logs the throughput */
+	void RunBenchmark(int32 NumProjectiles, int32 NumFrames);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	uint16 FindOrAddType(UClass* ProjectileClass);
+
+	void SweepBatches(const FVRiCCProjectileSoA& Data);
+	void ResolveHits(FVRiCCProjectileSoA& Data);
+	void RemoveProjectile(FVRiCCProjectileSoA& Data, int32 Index);
+	void UpdateProxies();
+
+	UPROPERTY(Transient)
+	TArray<FVRiCCProjectileType> Types;
+
+	FVRiCCProjectileSoA Projectiles;
+
+	/** Sweep output, indexed like the projectile arrays */
+	TArray<FHitResult> SweepHits;
+	TArray<uint8> SweepHitFlags;
+
+	/** Owners resolved on the game thread so sweep workers never touch weak pointers */
+	TArray<const AActor*> SweepIgnoreActors;
+
+	FVRiCCProjectileManagerStats Stats;
+};
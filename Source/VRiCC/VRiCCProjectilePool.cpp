@@ -0,0 +1,115 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCProjectilePool.h"
+#include "VRiCCProjectile.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static FAutoConsoleCommandWithWorld GProjectilePoolStatsCommand(
+	TEXT("VRiCC.ProjectilePool.Stats"),
+	TEXT("Prints free, active, high water mark and miss counts of every projectile pool."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCProjectilePoolSubsystem* ProjectilePool = World != nullptr ? World->GetSubsystem<UVRiCCProjectilePoolSubsystem>() : nullptr)
+		{
+			for (const TPair<TObjectPtr<UClass>, FVRiCCProjectilePool>& Pair : ProjectilePool->GetPools())
+			{
+				const FVRiCCProjectilePool& Pool = Pair.Value;
+				UE_LOG(LogTemp, Display, TEXT("ProjectilePool %s: free %d, active %d, high water mark %d, acquires %d, misses %d"),
+					*GetNameSafe(Pair.Key), Pool.Free.Num(), Pool.NumActive, Pool.HighWaterMark, Pool.Acquires, Pool.Misses);
+			}
+		}
+	}));
+
+bool UVRiCCProjectilePoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+AVRiCCProjectile* UVRiCCProjectilePoolSubsystem::SpawnPooled(UClass* ProjectileClass)
+{
+	// spawned far away and switched off straight away, Acquire moves it into place
+	const FTransform Transform(FRotator::ZeroRotator, FVector(0.f, 0.f, -HALF_WORLD_MAX));
+	AVRiCCProjectile* Projectile = GetWorld()->SpawnActorDeferred<AVRiCCProjectile>(ProjectileClass, Transform, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+	if (Projectile != nullptr)
+	{
+		Projectile->SetPooled(true);
+		Projectile->FinishSpawning(Transform);
+		Projectile->DeactivateProjectile();
+	}
+	return Projectile;
+}
+
+void UVRiCCProjectilePoolSubsystem::Prewarm(TSubclassOf<AVRiCCProjectile> ProjectileClass, int32 Count)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return;
+	}
+
+	FVRiCCProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass.Get());
+	Pool.Free.Reserve(Count);
+	while (Pool.Free.Num() + Pool.NumActive < Count)
+	{
+		AVRiCCProjectile* Projectile = SpawnPooled(ProjectileClass);
+		if (Projectile == nullptr)
+		{
+			break;
+		}
+		Pool.Free.Add(Projectile);
+	}
+}
+
+AVRiCCProjectile* UVRiCCProjectilePoolSubsystem::Acquire(TSubclassOf<AVRiCCProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator)
+{
+	if (ProjectileClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	FVRiCCProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass.Get());
+	Pool.Acquires++;
+
+	// skip instances destroyed behind our back, e.g. by a level reset
+	AVRiCCProjectile* Projectile = nullptr;
+	while (Projectile == nullptr && Pool.Free.Num() > 0)
+	{
+		Projectile = Pool.Free.Pop(false);
+		if (!IsValid(Projectile))
+		{
+			Projectile = nullptr;
+		}
+	}
+
+	if (Projectile == nullptr)
+	{
+		Pool.Misses++;
+		Projectile = SpawnPooled(ProjectileClass);
+		if (Projectile == nullptr)
+		{
+			return nullptr;
+		}
+	}
+
+	Pool.NumActive++;
+	Pool.HighWaterMark = FMath::Max(Pool.HighWaterMark, Pool.NumActive);
+
+	Projectile->SetOwner(Owner);
+	Projectile->SetInstigator(Instigator);
+	Projectile->ActivateProjectile(Transform);
+	return Projectile;
+}
+
+void UVRiCCProjectilePoolSubsystem::Release(AVRiCCProjectile* Projectile)
+{
+	if (!IsValid(Projectile) || !Projectile->IsProjectileActive())
+	{
+		return;
+	}
+
+	Projectile->DeactivateProjectile();
+
+	FVRiCCProjectilePool& Pool = Pools.FindOrAdd(Projectile->GetClass());
+	Pool.NumActive = FMath::Max(Pool.NumActive - 1, 0);
+	Pool.Free.Add(Projectile);
+}
@@ -0,0 +1,62 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCProjectilePool.generated.h"
+
+class AVRiCCProjectile;
+
+/** Recycled instances of one projectile class */
+USTRUCT()
+struct FVRiCCProjectilePool
+{
+	GENERATED_BODY()
+
+	/** Deactivated projectiles ready to be reused */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AVRiCCProjectile>> Free;
+
+	int32 NumActive = 0;
+
+	/** Most projectiles of this class alive at the same time */
+	int32 HighWaterMark = 0;
+
+	/** Acquires that found the pool empty and had to spawn a new actor */
+	int32 Misses = 0;
+
+	int32 Acquires = 0;
+};
+
+/**
+ * Keeps deactivated projectile actors around so firing and expiring
+ * reuse the same instances instead of spawning and destroying actors.
+ */
+UCLASS()
+class VRICC_API UVRiCCProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Spawns deactivated projectiles until the pool of ProjectileClass holds at least Count instances */
+	void Prewarm(TSubclassOf<AVRiCCProjectile> ProjectileClass, int32 Count);
+
+	/** Takes a projectile from the pool, spawning one if it is empty, and launches it from Transform */
+	AVRiCCProjectile* Acquire(TSubclassOf<AVRiCCProjectile> ProjectileClass, const FTransform& Transform, AActor* Owner, APawn* Instigator);
+
+	/** Deactivates Projectile and makes it available again */
+	void Release(AVRiCCProjectile* Projectile);
+
+	const FVRiCCProjectilePool* FindPool(TSubclassOf<AVRiCCProjectile> ProjectileClass) const { return Pools.Find(ProjectileClass.Get()); }
+	const TMap<TObjectPtr<UClass>, FVRiCCProjectilePool>& GetPools() const { return Pools; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	AVRiCCProjectile* SpawnPooled(UClass* ProjectileClass);
+
+	UPROPERTY(Transient)
+	TMap<TObjectPtr<UClass>, FVRiCCProjectilePool> Pools;
+};
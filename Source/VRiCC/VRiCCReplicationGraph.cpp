@@ -0,0 +1,262 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCReplicationGraph.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCProjectile.h"
+#include "WeaponSpawner.h"
+#include "TP_PickUpComponent.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Info.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarRepGraphNearDistance(
+	TEXT("VRiCC.RepGraph.NearDistance"),
+	3000.f,
+	TEXT("Characters closer than this to a viewer replicate every frame."));
+
+static TAutoConsoleVariable<float> CVarRepGraphMidDistance(
+	TEXT("VRiCC.RepGraph.MidDistance"),
+	8000.f,
+	TEXT("Characters closer than this to a viewer replicate every VRiCC.RepGraph.MidPeriod frames, further ones every VRiCC.RepGraph.FarPeriod frames."));
+
+static TAutoConsoleVariable<int32> CVarRepGraphMidPeriod(
+	TEXT("VRiCC.RepGraph.MidPeriod"),
+	2,
+	TEXT("Replication period in frames of characters in the mid distance bucket."));
+
+static TAutoConsoleVariable<int32> CVarRepGraphFarPeriod(
+	TEXT("VRiCC.RepGraph.FarPeriod"),
+	4,
+	TEXT("Replication period in frames of characters in the far distance bucket."));
+
+static TAutoConsoleVariable<int32> CVarRepGraphBucketRefreshFrames(
+	TEXT("VRiCC.RepGraph.BucketRefreshFrames"),
+	8,
+	TEXT("Frames between re-bucketing the characters of one connection, connections are staggered across these frames."));
+
+static FAutoConsoleCommandWithWorld GRepGraphStatsCommand(
+	TEXT("VRiCC.RepGraph.Stats"),
+	TEXT("Prints how many actors the replication graph routes into each node."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const UNetDriver* NetDriver = World != nullptr ? World->GetNetDriver() : nullptr;
+		if (const UVRiCCReplicationGraph* RepGraph = NetDriver != nullptr ? Cast<UVRiCCReplicationGraph>(NetDriver->GetReplicationDriver()) : nullptr)
+		{
+			UE_LOG(LogTemp, Display, TEXT("RepGraph: all connections %d, static %d, dynamic %d, dormancy %d, not routed %d"),
+				RepGraph->GetNumRouted(EVRiCCClassRepNodeMapping::RelevantAllConnections),
+				RepGraph->GetNumRouted(EVRiCCClassRepNodeMapping::Spatialize_Static),
+				RepGraph->GetNumRouted(EVRiCCClassRepNodeMapping::Spatialize_Dynamic),
+				RepGraph->GetNumRouted(EVRiCCClassRepNodeMapping::Spatialize_Dormancy),
+				RepGraph->GetNumRouted(EVRiCCClassRepNodeMapping::NotRouted));
+		}
+		else
+		{
+			UE_LOG(LogTemp, Display, TEXT("RepGraph: no VRiCCReplicationGraph on this world's net driver"));
+		}
+	}));
+
+//////////////////////////////////////////////////////////////////////////
+// UVRiCCReplicationGraphNode_CharacterFrequency
+
+void UVRiCCReplicationGraphNode_CharacterFrequency::NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo)
+{
+	Characters.Add(ActorInfo.Actor);
+}
+
+bool UVRiCCReplicationGraphNode_CharacterFrequency::NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound)
+{
+	return Characters.RemoveFast(ActorInfo.Actor);
+}
+
+void UVRiCCReplicationGraphNode_CharacterFrequency::NotifyResetAllNetworkActors()
+{
+	Characters.Reset();
+}
+
+void UVRiCCReplicationGraphNode_CharacterFrequency::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	// buckets change slowly, each connection is re-bucketed on its own frame of the refresh cycle
+	const uint32 RefreshFrames = uint32(FMath::Max(CVarRepGraphBucketRefreshFrames.GetValueOnGameThread(), 1));
+	if ((Params.ReplicationFrameNum + uint32(Params.ConnectionManager.ConnectionOrderNum)) % RefreshFrames != 0)
+	{
+		return;
+	}
+
+	const float NearDistanceSq = FMath::Square(CVarRepGraphNearDistance.GetValueOnGameThread());
+	const float MidDistanceSq = FMath::Square(CVarRepGraphMidDistance.GetValueOnGameThread());
+	const uint32 MidPeriod = uint32(FMath::Clamp(CVarRepGraphMidPeriod.GetValueOnGameThread(), 1, 255));
+	const uint32 FarPeriod = uint32(FMath::Clamp(CVarRepGraphFarPeriod.GetValueOnGameThread(), 1, 255));
+
+	for (FActorRepListType Actor : Characters)
+	{
+		// split screen connections have several viewers, the closest one decides
+		double ClosestDistanceSq = TNumericLimits<double>::Max();
+		for (const FNetViewer& Viewer : Params.Viewers)
+		{
+			ClosestDistanceSq = FMath::Min(ClosestDistanceSq, FVector::DistSquared(Viewer.ViewLocation, Actor->GetActorLocation()));
+		}
+
+		uint32 Period = FarPeriod;
+		if (ClosestDistanceSq < NearDistanceSq)
+		{
+			Period = 1;
+		}
+		else if (ClosestDistanceSq < MidDistanceSq)
+		{
+			Period = MidPeriod;
+		}
+
+		FConnectionReplicationActorInfo& ConnectionInfo = Params.ConnectionManager.ActorInfoMap.FindOrAdd(Actor);
+		ConnectionInfo.ReplicationPeriodFrame = static_cast<decltype(ConnectionInfo.ReplicationPeriodFrame)>(Period);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+// UVRiCCReplicationGraph
+
+void UVRiCCReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	FClassReplicationInfo CharacterInfo;
+	CharacterInfo.DistancePriorityScale = 1.f;
+	CharacterInfo.StarvationPriorityScale = 1.f;
+	CharacterInfo.SetCullDistanceSquared(FMath::Square(CharacterCullDistance));
+	GlobalActorReplicationInfoMap.SetClassInfo(AVRiCCCharacter::StaticClass(), CharacterInfo);
+
+	FClassReplicationInfo ProjectileInfo = CharacterInfo;
+	GlobalActorReplicationInfoMap.SetClassInfo(AVRiCCProjectile::StaticClass(), ProjectileInfo);
+
+	FClassReplicationInfo SpawnerInfo;
+	SpawnerInfo.SetCullDistanceSquared(FMath::Square(PickUpCullDistance));
+	SpawnerInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(2.f);
+	GlobalActorReplicationInfoMap.SetClassInfo(AWeaponSpawner::StaticClass(), SpawnerInfo);
+
+	// scoreboard data, nobody needs it at the full rate
+	FClassReplicationInfo PlayerStateInfo;
+	PlayerStateInfo.DistancePriorityScale = 0.f;
+	PlayerStateInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(2.f);
+	GlobalActorReplicationInfoMap.SetClassInfo(APlayerState::StaticClass(), PlayerStateInfo);
+}
+
+void UVRiCCReplicationGraph::InitGlobalGraphNodes()
+{
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	// the grid starts at the bias, shift it so the playable area around the origin is covered
+	GridNode->SpatialBias = FVector2D(-GridCellSize * 16.f, -GridCellSize * 16.f);
+	AddGlobalGraphNode(GridNode);
+
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+
+	CharacterFrequencyNode = CreateNewNode<UVRiCCReplicationGraphNode_CharacterFrequency>();
+	AddGlobalGraphNode(CharacterFrequencyNode);
+}
+
+void UVRiCCReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	// the connection's own controller, pawn and view target
+	UReplicationGraphNode_AlwaysRelevant_ForConnection* AlwaysRelevantForConnectionNode = CreateNewNode<UReplicationGraphNode_AlwaysRelevant_ForConnection>();
+	AddConnectionGraphNode(AlwaysRelevantForConnectionNode, RepGraphConnection);
+}
+
+EVRiCCClassRepNodeMapping UVRiCCReplicationGraph::GetMappingPolicy(const AActor* Actor) const
+{
+	if (Actor->bAlwaysRelevant || Actor->IsA<AInfo>())
+	{
+		return EVRiCCClassRepNodeMapping::RelevantAllConnections;
+	}
+
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		return EVRiCCClassRepNodeMapping::NotRouted;
+	}
+
+	// spawners never move and pickups only while carried, both stay dormant until they change
+	if (Actor->IsA<AWeaponSpawner>() || Actor->FindComponentByClass<UTP_PickUpComponent>() != nullptr)
+	{
+		return EVRiCCClassRepNodeMapping::Spatialize_Dormancy;
+	}
+
+	if (Actor->IsA<AVRiCCCharacter>() || Actor->IsA<AVRiCCProjectile>())
+	{
+		return EVRiCCClassRepNodeMapping::Spatialize_Dynamic;
+	}
+
+	// decided from the class defaults so adding and removing an actor always agree on its mapping
+	const AActor* ClassDefault = Actor->GetClass()->GetDefaultObject<AActor>();
+	if (ClassDefault->IsReplicatingMovement())
+	{
+		return EVRiCCClassRepNodeMapping::Spatialize_Dynamic;
+	}
+	return ClassDefault->NetDormancy > DORM_Awake ? EVRiCCClassRepNodeMapping::Spatialize_Dormancy : EVRiCCClassRepNodeMapping::Spatialize_Static;
+}
+
+void UVRiCCReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const EVRiCCClassRepNodeMapping Mapping = GetMappingPolicy(ActorInfo.Actor);
+	NumRouted[int32(Mapping)]++;
+
+	switch (Mapping)
+	{
+	case EVRiCCClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EVRiCCClassRepNodeMapping::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EVRiCCClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		if (ActorInfo.Actor->IsA<AVRiCCCharacter>())
+		{
+			CharacterFrequencyNode->NotifyAddNetworkActor(ActorInfo);
+		}
+		break;
+
+	case EVRiCCClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UVRiCCReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	const EVRiCCClassRepNodeMapping Mapping = GetMappingPolicy(ActorInfo.Actor);
+	NumRouted[int32(Mapping)]--;
+
+	switch (Mapping)
+	{
+	case EVRiCCClassRepNodeMapping::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EVRiCCClassRepNodeMapping::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EVRiCCClassRepNodeMapping::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		if (ActorInfo.Actor->IsA<AVRiCCCharacter>())
+		{
+			CharacterFrequencyNode->NotifyRemoveNetworkActor(ActorInfo);
+		}
+		break;
+
+	case EVRiCCClassRepNodeMapping::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+}
@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "VRiCCReplicationGraph.generated.h"
+
+class UReplicationGraphNode_GridSpatialization2D;
+class UReplicationGraphNode_ActorList;
+
+/** How an actor is routed into the replication graph */
+enum class EVRiCCClassRepNodeMapping : uint8
+{
+	/** Not in any global node, e.g. only relevant to its owner and picked up by the per connection node */
+	NotRouted,
+	/** Replicated to every connection */
+	RelevantAllConnections,
+	/** Grid cell it starts in, never moves */
+	Spatialize_Static,
+	/** Grid cells recomputed every frame */
+	Spatialize_Dynamic,
+	/** Treated as static while dormant and as dynamic while awake */
+	Spatialize_Dormancy,
+
+	Num
+};
+
+/**
+ * Throttles characters by their distance to each viewer of a connection.
+ * Characters still reach connections through the grid, this node gathers no lists and only
+ * sets the per connection replication period of every character to the bucket it falls into.
+ */
+UCLASS()
+class VRICC_API UVRiCCReplicationGraphNode_CharacterFrequency : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	// UReplicationGraphNode interface
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override;
+	virtual void NotifyResetAllNetworkActors() override;
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+	// End of UReplicationGraphNode interface
+
+private:
+	FActorRepListRefView Characters;
+};
+
+/**
+ * Replication driver of the project, set as ReplicationDriverClassName of the IpNetDriver.
+ * Characters and projectiles live in a 2D spatial grid, spawners and pickups in the same grid
+ * but dormant until they change, so each connection only considers the actors in the cells around it.
+ */
+UCLASS(Transient, config = Engine)
+class VRICC_API UVRiCCReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	// UReplicationGraph interface
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	// End of UReplicationGraph interface
+
+	/** Number of actors currently routed with each mapping */
+	int32 GetNumRouted(EVRiCCClassRepNodeMapping Mapping) const { return NumRouted[int32(Mapping)]; }
+
+	/** Size of a grid cell in world units */
+	UPROPERTY(config)
+	float GridCellSize = 10000.f;
+
+	/** Characters further away than this are not replicated at all */
+	UPROPERTY(config)
+	float CharacterCullDistance = 15000.f;
+
+	/** Spawners and pickups further away than this are not replicated at all */
+	UPROPERTY(config)
+	float PickUpCullDistance = 8000.f;
+
+private:
+	EVRiCCClassRepNodeMapping GetMappingPolicy(const AActor* Actor) const;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+	UPROPERTY()
+	TObjectPtr<UVRiCCReplicationGraphNode_CharacterFrequency> CharacterFrequencyNode;
+
+	int32 NumRouted[int32(EVRiCCClassRepNodeMapping::Num)] = {};
+};
@@ -0,0 +1,159 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCShotDebug.h"
+#include "VRiCC.h"
+#include "DrawDebugHelpers.h"
+#include "Engine/World.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryWriter.h"
+
+static TAutoConsoleVariable<int32> CVarShotDebugDraw(
+	TEXT("VRiCC.ShotDebug.Draw"),
+	0,
+	TEXT("Draws the recorded shots of the last VRiCC.ShotDebug.DrawSeconds: red hits, blue physics hits, green misses, purple server verdicts."));
+
+static TAutoConsoleVariable<float> CVarShotDebugDrawSeconds(
+	TEXT("VRiCC.ShotDebug.DrawSeconds"),
+	1.f,
+	TEXT("How long a recorded shot stays drawn."));
+
+static FAutoConsoleCommandWithWorldAndArgs GShotDebugExportCommand(
+	TEXT("VRiCC.ShotDebug.Export"),
+	TEXT("Writes the recorded shots to a binary file. Usage: VRiCC.ShotDebug.Export [Path], defaults to Saved/ShotDebug/."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UVRiCCShotDebugSubsystem* ShotDebug = World != nullptr ? World->GetSubsystem<UVRiCCShotDebugSubsystem>() : nullptr;
+		if (ShotDebug == nullptr)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShotDebug: not available in this world"));
+			return;
+		}
+
+		const FString Path = Args.Num() > 0 ? Args[0] : FPaths::ProjectSavedDir() / TEXT("ShotDebug") / FString::Printf(TEXT("Shots-%s.bin"), *FDateTime::Now().ToString());
+		if (ShotDebug->ExportToFile(Path))
+		{
+			UE_LOG(LogTemp, Display, TEXT("ShotDebug: wrote %d shots to %s"), ShotDebug->Num(), *Path);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ShotDebug: could not write %s"), *Path);
+		}
+	}));
+
+bool UVRiCCShotDebugSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if VRICC_WITH_SHOT_DEBUG
+	return Super::ShouldCreateSubsystem(Outer);
+#else
+	return false;
+#endif
+}
+
+bool UVRiCCShotDebugSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UVRiCCShotDebugSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	// the ring is allocated once, recording never allocates
+	Records.SetNum(Capacity);
+}
+
+TStatId UVRiCCShotDebugSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCShotDebugSubsystem, STATGROUP_Tickables);
+}
+
+bool UVRiCCShotDebugSubsystem::IsTickable() const
+{
+	return NumRecords > 0 && CVarShotDebugDraw.GetValueOnGameThread() != 0;
+}
+
+void UVRiCCShotDebugSubsystem::RecordShot(const FVector& Start, const FVector& End, const AActor* HitActor, EVRiCCShotDebugResult Result)
+{
+	FVRiCCShotDebugRecord& Record = Records[Head];
+	Record.Start = Start;
+	Record.End = End;
+	Record.Time = GetWorld()->GetTimeSeconds();
+	Record.HitActor = HitActor;
+	Record.Result = Result;
+
+	Head = (Head + 1) % Capacity;
+	NumRecords = FMath::Min(NumRecords + 1, Capacity);
+}
+
+void UVRiCCShotDebugSubsystem::Tick(float DeltaTime)
+{
+#if VRICC_WITH_SHOT_DEBUG && ENABLE_DRAW_DEBUG
+	UWorld* World = GetWorld();
+	const double OldestTime = World->GetTimeSeconds() - CVarShotDebugDrawSeconds.GetValueOnGameThread();
+
+	// newest first, stop at the first record that is too old
+	for (int32 Age = 0; Age < NumRecords; ++Age)
+	{
+		const FVRiCCShotDebugRecord& Record = Records[(Head - 1 - Age + Capacity) % Capacity];
+		if (Record.Time < OldestTime)
+		{
+			break;
+		}
+
+		FColor Color = FColor::Red;
+		switch (Record.Result)
+		{
+		case EVRiCCShotDebugResult::Miss:
+			Color = FColor::Green;
+			break;
+		case EVRiCCShotDebugResult::PhysicsHit:
+			Color = FColor::Blue;
+			break;
+		case EVRiCCShotDebugResult::ServerMiss:
+		case EVRiCCShotDebugResult::ServerHit:
+		case EVRiCCShotDebugResult::ServerRejected:
+			Color = FColor::Purple;
+			break;
+		default:
+			break;
+		}
+
+		// drawn for one frame, the ring is drawn again next frame while the record is recent
+		DrawDebugLine(World, Record.Start, Record.End, Color, false, -1.f, 0, 0.5f);
+		if (Record.Result != EVRiCCShotDebugResult::Miss && Record.Result != EVRiCCShotDebugResult::ServerMiss)
+		{
+			DrawDebugPoint(World, Record.End, 6.f, Color, false, -1.f);
+		}
+	}
+#endif
+}
+
+bool UVRiCCShotDebugSubsystem::ExportToFile(const FString& Path) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+
+	uint32 Magic = ExportMagic;
+	uint32 Version = ExportVersion;
+	int32 Count = NumRecords;
+	Writer << Magic << Version << Count;
+
+	// oldest first, actor names are looked up here instead of when the shot was recorded
+	const int32 Oldest = (Head - NumRecords + Capacity) % Capacity;
+	for (int32 Index = 0; Index < NumRecords; ++Index)
+	{
+		const FVRiCCShotDebugRecord& Record = Records[(Oldest + Index) % Capacity];
+		FVector Start = Record.Start;
+		FVector End = Record.End;
+		double Time = Record.Time;
+		uint8 Result = uint8(Record.Result);
+		const AActor* HitActor = Record.HitActor.Get();
+		FString HitActorName = HitActor != nullptr ? HitActor->GetName() : FString();
+		Writer << Start << End << Time << Result << HitActorName;
+	}
+
+	return FFileHelper::SaveArrayToFile(Bytes, *Path);
+}
@@ -0,0 +1,84 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCShotDebug.generated.h"
+
+/** How a recorded shot ended, stored as one byte in the export */
+enum class EVRiCCShotDebugResult : uint8
+{
+	/** Client trace that hit nothing */
+	Miss,
+	/** Client trace stopped by world geometry */
+	WorldHit,
+	/** Client trace that pushed a simulating physics body */
+	PhysicsHit,
+	/** Client trace that hit a character hitbox */
+	CharacterHit,
+	/** Server validation found no character */
+	ServerMiss,
+	ServerHit,
+	/** Server rejected the shot origin */
+	ServerRejected,
+};
+
+/** One shot in the debug ring */
+struct FVRiCCShotDebugRecord
+{
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+	/** World time the shot was recorded at */
+	double Time = 0.0;
+	/** Only resolved to a name when the ring is exported */
+	TWeakObjectPtr<const AActor> HitActor;
+	EVRiCCShotDebugResult Result = EVRiCCShotDebugResult::Miss;
+};
+
+/**
+ * Keeps the last Capacity shots of the world in a fixed ring, so recording a shot is a copy into a slot.
+ * VRiCC.ShotDebug.Draw draws the recent ones, VRiCC.ShotDebug.Export writes the ring to Saved/ShotDebug/.
+ * Callers record under VRICC_WITH_SHOT_DEBUG, which compiles out of shipping builds along with this subsystem's work.
+ */
+UCLASS()
+class VRICC_API UVRiCCShotDebugSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	static constexpr int32 Capacity = 1024;
+
+	/** Export file layout: Magic, Version, record count, then per record Start, End, Time, Result and the hit actor name */
+	static constexpr uint32 ExportMagic = 0x44535256; // "VRSD"
+	static constexpr uint32 ExportVersion = 1;
+
+	// USubsystem interface
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	// End of USubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Overwrites the oldest record once the ring is full */
+	void RecordShot(const FVector& Start, const FVector& End, const AActor* HitActor, EVRiCCShotDebugResult Result);
+
+	/** Writes the ring oldest first, returns false if the file could not be written */
+	bool ExportToFile(const FString& Path) const;
+
+	int32 Num() const { return NumRecords; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	TArray<FVRiCCShotDebugRecord> Records;
+
+	/** Slot the next record goes to */
+	int32 Head = 0;
+	int32 NumRecords = 0;
+};
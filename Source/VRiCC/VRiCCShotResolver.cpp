@@ -0,0 +1,299 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCShotResolver.h"
+#include "TP_WeaponComponent.h"
+#include "VRiCC.h"
+#include "VRiCCCharacter.h"
+#include "VRiCCShotDebug.h"
+#include "VRiCCStats.h"
+#include "Algo/Count.h"
+#include "Async/ParallelFor.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+static TAutoConsoleVariable<bool> CVarShotResolverParallel(
+	TEXT("VRiCC.ShotResolver.Parallel"),
+	true,
+	TEXT("Validates server shots on task graph workers, false runs every batch on the game thread."));
+
+static TAutoConsoleVariable<int32> CVarShotResolverBatchSize(
+	TEXT("VRiCC.ShotResolver.BatchSize"),
+	32,
+	TEXT("Shots per task graph batch, smaller frames are validated on the game thread alone."));
+
+static TAutoConsoleVariable<float> CVarShotResolverMaxOriginError(
+	TEXT("VRiCC.ShotResolver.MaxOriginError"),
+	200.f,
+	TEXT("Farthest a shot may start from the shooter's rewound capsule center before it is rejected."));
+
+static FAutoConsoleCommandWithWorld GShotResolverStatsCommand(
+	TEXT("VRiCC.ShotResolver.Stats"),
+	TEXT("Prints the server shot resolver counters."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCShotResolverSubsystem* Resolver = World != nullptr ? World->GetSubsystem<UVRiCCShotResolverSubsystem>() : nullptr)
+		{
+			const FVRiCCShotResolverStats& Stats = Resolver->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("ShotResolver: total %llu, hits %llu, rejected origin %llu, clamped times %llu, last batch %d shots in %d batches, validate %.3fms, commit %.3fms"),
+				Stats.TotalShots, Stats.Hits, Stats.RejectedOrigin, Stats.ClampedTimes, Stats.ShotsLastBatch, Stats.BatchesLastBatch, Stats.ValidateMs, Stats.CommitMs);
+		}
+	}));
+
+static FAutoConsoleCommand GShotResolverBenchmarkCommand(
+	TEXT("VRiCC.ShotResolver.Benchmark"),
+	TEXT("VRiCC.ShotResolver.Benchmark [NumShots=4096] [NumTargets=64] [MaxBatches=workers+1]: shot validation time from 1 to MaxBatches parallel batches."),
+	FConsoleCommandWithArgsDelegate::CreateStatic([](const TArray<FString>& Args)
+	{
+		const int32 NumShots = Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 4096;
+		const int32 NumTargets = Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 64;
+		const int32 MaxBatches = Args.Num() > 2 ? FCString::Atoi(*Args[2]) : FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+		UVRiCCShotResolverSubsystem::RunBenchmark(FMath::Max(NumShots, 1), FMath::Max(NumTargets, 1), FMath::Max(MaxBatches, 1));
+	}));
+
+bool UVRiCCShotResolverSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UVRiCCShotResolverSubsystem::Enqueue(UTP_WeaponComponent* Weapon, AVRiCCCharacter* Shooter, const FVector& Start, const FVector& End, double ShotTime, const FHitResult* WorldHit, bool bApplyImpact)
+{
+	FVRiCCShotRequest& Request = Pending.AddDefaulted_GetRef();
+	Request.Weapon = Weapon;
+	Request.Shooter = Shooter;
+	Request.Start = Start;
+	Request.End = End;
+	Request.ShotTime = ShotTime;
+	Request.bApplyImpact = bApplyImpact;
+	if (bApplyImpact && WorldHit != nullptr && WorldHit->bBlockingHit)
+	{
+		Request.bWorldHit = true;
+		Request.WorldHit = *WorldHit;
+	}
+}
+
+void UVRiCCShotResolverSubsystem::ResolvePending()
+{
+	VRICC_SCOPE_CYCLE(ShotResolver);
+
+	Stats.ShotsLastBatch = Pending.Num();
+	if (Pending.Num() == 0)
+	{
+		return;
+	}
+
+	UVRiCCLagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<UVRiCCLagCompensationSubsystem>();
+	if (LagCompensation == nullptr)
+	{
+		Pending.Reset();
+		return;
+	}
+
+	// everything the workers need is read here, on the game thread
+	LagCompensation->GatherTargets(Targets);
+	for (FVRiCCShotRequest& Request : Pending)
+	{
+		Request.ShooterIndex = Targets.IndexOfByPredicate([&Request](const FVRiCCHitboxTarget& Target)
+		{
+			return Target.Character == Request.Shooter;
+		});
+	}
+
+	FVRiCCShotValidationParams Params;
+	Params.Now = GetWorld()->GetTimeSeconds();
+	Params.MaxRewind = UVRiCCLagCompensationSubsystem::GetMaxRewind();
+	Params.LastRecordTime = LagCompensation->GetLastRecordTime();
+	Params.MaxOriginErrorSquared = FMath::Square(CVarShotResolverMaxOriginError.GetValueOnGameThread());
+
+	const int32 BatchSize = FMath::Max(CVarShotResolverBatchSize.GetValueOnGameThread(), 1);
+	const int32 NumBatches = CVarShotResolverParallel.GetValueOnGameThread() ? FMath::DivideAndRoundUp(Pending.Num(), BatchSize) : 1;
+
+	const double StartSeconds = FPlatformTime::Seconds();
+	Results.SetNum(Pending.Num(), false);
+	ValidateShots(Pending, Targets, Params, Results, NumBatches);
+
+	const double ValidatedSeconds = FPlatformTime::Seconds();
+	Commit();
+
+	Stats.BatchesLastBatch = NumBatches;
+	Stats.TotalShots += Pending.Num();
+	Stats.ValidateMs = (ValidatedSeconds - StartSeconds) * 1000.0;
+	Stats.CommitMs = (FPlatformTime::Seconds() - ValidatedSeconds) * 1000.0;
+
+	// keep the allocations for the next frame
+	Pending.Reset();
+	Targets.Reset();
+}
+
+void UVRiCCShotResolverSubsystem::ValidateShots(TConstArrayView<FVRiCCShotRequest> Requests, TConstArrayView<FVRiCCHitboxTarget> Targets, const FVRiCCShotValidationParams& Params, TArrayView<FVRiCCShotResult> Results, int32 NumBatches)
+{
+	check(Results.Num() == Requests.Num());
+
+	const int32 Num = Requests.Num();
+	NumBatches = FMath::Clamp(NumBatches, 1, FMath::Max(Num, 1));
+	const int32 BatchSize = FMath::DivideAndRoundUp(Num, NumBatches);
+
+	// every shot writes only its own result, so batches never touch shared state
+	ParallelFor(NumBatches, [&Requests, &Targets, &Params, &Results, BatchSize, Num](int32 BatchIndex)
+	{
+		const int32 First = BatchIndex * BatchSize;
+		const int32 Last = FMath::Min(First + BatchSize, Num);
+		for (int32 Index = First; Index < Last; ++Index)
+		{
+			const FVRiCCShotRequest& Request = Requests[Index];
+			FVRiCCShotResult& Result = Results[Index];
+			Result = FVRiCCShotResult();
+
+			const double ShotTime = FMath::Clamp(Request.ShotTime, Params.Now - Params.MaxRewind, Params.Now);
+			Result.bTimeClamped = ShotTime != Request.ShotTime;
+			const bool bUseLivePose = ShotTime >= Params.LastRecordTime;
+
+			// the shot has to leave the shooter's own capsule as it was at the claimed time
+			if (Targets.IsValidIndex(Request.ShooterIndex))
+			{
+				const FVRiCCHitboxTarget& Shooter = Targets[Request.ShooterIndex];
+				FVRiCCHitboxPose ShooterPose = Shooter.LivePose;
+				if (bUseLivePose || (Shooter.History != nullptr && Shooter.History->Sample(ShotTime, ShooterPose)))
+				{
+					if (FVector::DistSquared(Request.Start, FVector(ShooterPose.Center)) > Params.MaxOriginErrorSquared)
+					{
+						Result.Verdict = EVRiCCShotVerdict::RejectedOrigin;
+						continue;
+					}
+				}
+			}
+
+			if (UVRiCCLagCompensationSubsystem::RewindTraceTargets(Targets, Request.Start, Request.End, ShotTime, bUseLivePose, Request.Shooter, Result.Hit))
+			{
+				Result.Verdict = EVRiCCShotVerdict::Hit;
+			}
+		}
+	}, NumBatches <= 1 ? EParallelForFlags::ForceSingleThread : EParallelForFlags::None);
+}
+
+// in delivery order on the game thread, the same shots always end in the same health values
+void UVRiCCShotResolverSubsystem::Commit()
+{
+#if VRICC_WITH_SHOT_DEBUG
+	UVRiCCShotDebugSubsystem* ShotDebug = GetWorld()->GetSubsystem<UVRiCCShotDebugSubsystem>();
+#endif
+
+	for (int32 Index = 0; Index < Pending.Num(); ++Index)
+	{
+		const FVRiCCShotRequest& Request = Pending[Index];
+		const FVRiCCShotResult& Result = Results[Index];
+		Stats.ClampedTimes += Result.bTimeClamped ? 1 : 0;
+
+#if VRICC_WITH_SHOT_DEBUG
+		// shots with impacts are recorded by their weapon
+		if (ShotDebug != nullptr && !Request.bApplyImpact)
+		{
+			switch (Result.Verdict)
+			{
+			case EVRiCCShotVerdict::Hit:
+				ShotDebug->RecordShot(Request.Start, Result.Hit.Location, Result.Hit.Character, EVRiCCShotDebugResult::ServerHit);
+				break;
+			case EVRiCCShotVerdict::RejectedOrigin:
+				ShotDebug->RecordShot(Request.Start, Request.End, nullptr, EVRiCCShotDebugResult::ServerRejected);
+				break;
+			default:
+				ShotDebug->RecordShot(Request.Start, Request.End, nullptr, EVRiCCShotDebugResult::ServerMiss);
+				break;
+			}
+		}
+#endif
+
+		UTP_WeaponComponent* Weapon = Request.Weapon.Get();
+		if (Result.Verdict == EVRiCCShotVerdict::RejectedOrigin)
+		{
+			Stats.RejectedOrigin++;
+		}
+		else if (Result.Verdict == EVRiCCShotVerdict::Hit && Weapon != nullptr && IsValid(Result.Hit.Character))
+		{
+			Stats.Hits++;
+			VRICC_COUNT(Hits, 1);
+			Weapon->ApplyServerHit(Result.Hit);
+			if (Request.bApplyImpact)
+			{
+				Weapon->ApplyShotImpact(Request.Start, Request.End, nullptr, &Result.Hit);
+			}
+			continue;
+		}
+
+		if (Request.bApplyImpact && Weapon != nullptr)
+		{
+			Weapon->ApplyShotImpact(Request.Start, Request.End, Request.bWorldHit ? &Request.WorldHit : nullptr, nullptr);
+		}
+	}
+}
+
+void UVRiCCShotResolverSubsystem::RunBenchmark(int32 NumShots, int32 NumTargets, int32 MaxBatches)
+{
+	// targets walking around a 100m square with a full second of history, shots from its edge across it
+	FRandomStream Random(NumShots);
+	const double Now = 10.0;
+
+	TArray<FVRiCCHitboxHistory> Histories;
+	Histories.SetNum(NumTargets);
+	TArray<FVRiCCHitboxTarget> Targets;
+	Targets.SetNum(NumTargets);
+	for (int32 TargetIndex = 0; TargetIndex < NumTargets; ++TargetIndex)
+	{
+		FVRiCCHitboxPose Pose;
+		Pose.Center = FVector3f(Random.FRandRange(-5000.f, 5000.f), Random.FRandRange(-5000.f, 5000.f), 100.f);
+		Pose.Radius = 55.f;
+		Pose.HalfHeight = 96.f;
+		const FVector3f Velocity(Random.FRandRange(-600.f, 600.f), Random.FRandRange(-600.f, 600.f), 0.f);
+
+		for (int32 Step = FVRiCCHitboxHistory::Capacity - 1; Step >= 0; --Step)
+		{
+			Pose.Time = Now - Step / 30.0;
+			Histories[TargetIndex].Record(Pose);
+			Pose.Center += Velocity / 30.f;
+		}
+		Targets[TargetIndex].History = &Histories[TargetIndex];
+		Targets[TargetIndex].LivePose = Pose;
+	}
+
+	TArray<FVRiCCShotRequest> Requests;
+	Requests.SetNum(NumShots);
+	for (FVRiCCShotRequest& Request : Requests)
+	{
+		const FVector Aim(Targets[Random.RandHelper(NumTargets)].LivePose.Center);
+		Request.Start = FVector(Random.FRandRange(-6000.f, 6000.f), -6000.0, 150.0);
+		Request.End = Request.Start + (Aim - Request.Start).GetSafeNormal() * 20000.0;
+		Request.ShotTime = Now - Random.FRandRange(0.f, 0.5f);
+	}
+
+	FVRiCCShotValidationParams Params;
+	Params.Now = Now;
+	Params.MaxRewind = 0.5;
+	Params.LastRecordTime = Now;
+	Params.MaxOriginErrorSquared = FMath::Square(200.0);
+
+	TArray<FVRiCCShotResult> Results;
+	Results.SetNum(NumShots);
+
+	const int32 NumIterations = 20;
+	double SingleBatchMs = 0.0;
+	for (int32 NumBatches = 1; NumBatches <= MaxBatches; ++NumBatches)
+	{
+		// best of several runs, the first one also warms the caches
+		double BestMs = UE_BIG_NUMBER;
+		for (int32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+		{
+			const double StartSeconds = FPlatformTime::Seconds();
+			ValidateShots(Requests, Targets, Params, Results, NumBatches);
+			BestMs = FMath::Min(BestMs, (FPlatformTime::Seconds() - StartSeconds) * 1000.0);
+		}
+
+		if (NumBatches == 1)
+		{
+			SingleBatchMs = BestMs;
+		}
+
+		const int32 NumHits = Algo::CountIf(Results, [](const FVRiCCShotResult& Result) { return Result.Verdict == EVRiCCShotVerdict::Hit; });
+		UE_LOG(LogTemp, Display, TEXT("ShotResolver benchmark: %d shots x %d targets, %d batches: %.3fms (%.2fx), %d hits"),
+			NumShots, NumTargets, NumBatches, BestMs, BestMs > 0.0 ? SingleBatchMs / BestMs : 0.0, NumHits);
+	}
+}
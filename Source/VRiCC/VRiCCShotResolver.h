@@ -0,0 +1,119 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/HitResult.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCLagCompensation.h"
+#include "VRiCCShotResolver.generated.h"
+
+class AVRiCCCharacter;
+class UTP_WeaponComponent;
+
+/** A server validation shot whose world geometry trace is done, waiting to be checked against the hitboxes */
+struct FVRiCCShotRequest
+{
+	TWeakObjectPtr<UTP_WeaponComponent> Weapon;
+	AVRiCCCharacter* Shooter = nullptr;
+
+	/** Index of the shooter in the gathered targets, filled in when the batch is resolved */
+	int32 ShooterIndex = INDEX_NONE;
+
+	FVector Start = FVector::ZeroVector;
+
+	/** Shot end, already shortened to the closest world geometry in the way */
+	FVector End = FVector::ZeroVector;
+
+	/** Shot time as reported by the client */
+	double ShotTime = 0.0;
+
+	/** Shot of a locally controlled shooter, the weapon gets the result for its impacts */
+	bool bApplyImpact = false;
+
+	/** World geometry the shot hit, only kept for bApplyImpact */
+	bool bWorldHit = false;
+	FHitResult WorldHit;
+};
+
+enum class EVRiCCShotVerdict : uint8
+{
+	Miss,
+	Hit,
+	/** The shot did not leave the shooter's own hitbox at the time it claims */
+	RejectedOrigin,
+};
+
+/** Outcome of validating one shot, written by a worker thread and committed on the game thread */
+struct FVRiCCShotResult
+{
+	EVRiCCShotVerdict Verdict = EVRiCCShotVerdict::Miss;
+
+	/** The reported time was outside the rewind window and was clamped into it */
+	bool bTimeClamped = false;
+
+	FVRiCCRewindHit Hit;
+};
+
+/** Values every shot of a batch is validated with, read once on the game thread */
+struct FVRiCCShotValidationParams
+{
+	double Now = 0.0;
+	double MaxRewind = 0.0;
+	double LastRecordTime = 0.0;
+	double MaxOriginErrorSquared = 0.0;
+};
+
+/** Counters of the shot resolver, "last batch" values are overwritten every batch */
+struct FVRiCCShotResolverStats
+{
+	int32 ShotsLastBatch = 0;
+	int32 BatchesLastBatch = 0;
+	uint64 TotalShots = 0;
+	uint64 Hits = 0;
+	uint64 RejectedOrigin = 0;
+	uint64 ClampedTimes = 0;
+
+	/** Parallel validation and serial commit of the last batch */
+	double ValidateMs = 0.0;
+	double CommitMs = 0.0;
+};
+
+/**
+ * Server side hit resolution of every validation shot delivered in a frame.
+ * The rewind lookups, ray versus capsule tests and origin checks run in parallel on task graph workers
+ * against a snapshot of the hitboxes, then damage is applied on the game thread in delivery order,
+ * so the outcome does not depend on how the work was split.
+ */
+UCLASS()
+class VRICC_API UVRiCCShotResolverSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	/** Queues a shot for the next ResolvePending, the trace queue calls it after delivering its results */
+	void Enqueue(UTP_WeaponComponent* Weapon, AVRiCCCharacter* Shooter, const FVector& Start, const FVector& End, double ShotTime, const FHitResult* WorldHit = nullptr, bool bApplyImpact = false);
+
+	/** Validates every queued shot in parallel and commits the hits */
+	void ResolvePending();
+
+	/** Validates Requests into Results split into NumBatches task graph batches, touches no UObject */
+	static void ValidateShots(TConstArrayView<FVRiCCShotRequest> Requests, TConstArrayView<FVRiCCHitboxTarget> Targets, const FVRiCCShotValidationParams& Params, TArrayView<FVRiCCShotResult> Results, int32 NumBatches);
+
+	/** Validates synthetic shots with 1 to MaxBatches batches and logs the time and speedup of each */
+	static void RunBenchmark(int32 NumShots, int32 NumTargets, int32 MaxBatches);
+
+	const FVRiCCShotResolverStats& GetStats() const { return Stats; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void Commit();
+
+	TArray<FVRiCCShotRequest> Pending;
+	TArray<FVRiCCShotResult> Results;
+	TArray<FVRiCCHitboxTarget> Targets;
+
+	FVRiCCShotResolverStats Stats;
+};
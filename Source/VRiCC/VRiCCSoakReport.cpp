@@ -0,0 +1,230 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCSoakReport.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "UObject/UObjectArray.h"
+#include "UObject/UObjectGlobals.h"
+
+static TAutoConsoleVariable<float> CVarSoakInterval(
+	TEXT("VRiCC.Soak.Interval"),
+	10.f,
+	TEXT("Seconds per soak report interval."));
+
+static FAutoConsoleCommandWithWorldAndArgs GSoakStartCommand(
+	TEXT("VRiCC.Soak.Start"),
+	TEXT("VRiCC.Soak.Start [DurationSeconds=0]: starts a soak report on this server, 0 runs until VRiCC.Soak.Stop."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		if (UVRiCCSoakReportSubsystem* SoakReport = World != nullptr ? World->GetSubsystem<UVRiCCSoakReportSubsystem>() : nullptr)
+		{
+			SoakReport->StartSoak(Args.Num() > 0 ? FCString::Atod(*Args[0]) : 0.0);
+		}
+	}));
+
+static FAutoConsoleCommandWithWorld GSoakStopCommand(
+	TEXT("VRiCC.Soak.Stop"),
+	TEXT("Ends the soak report and writes it to Saved/Soak/."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (UVRiCCSoakReportSubsystem* SoakReport = World != nullptr ? World->GetSubsystem<UVRiCCSoakReportSubsystem>() : nullptr)
+		{
+			SoakReport->StopSoak();
+		}
+	}));
+
+bool UVRiCCSoakReportSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UVRiCCSoakReportSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCSoakReportSubsystem, STATGROUP_Tickables);
+}
+
+void UVRiCCSoakReportSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	PreGCHandle = FCoreUObjectDelegates::GetPreGarbageCollectDelegate().AddUObject(this, &UVRiCCSoakReportSubsystem::OnPreGarbageCollect);
+	PostGCHandle = FCoreUObjectDelegates::GetPostGarbageCollect().AddUObject(this, &UVRiCCSoakReportSubsystem::OnPostGarbageCollect);
+}
+
+void UVRiCCSoakReportSubsystem::Deinitialize()
+{
+	if (bRunning)
+	{
+		StopSoak();
+	}
+
+	FCoreUObjectDelegates::GetPreGarbageCollectDelegate().Remove(PreGCHandle);
+	FCoreUObjectDelegates::GetPostGarbageCollect().Remove(PostGCHandle);
+
+	Super::Deinitialize();
+}
+
+void UVRiCCSoakReportSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// clients only report what they see of the server, the soak numbers come from the server itself
+	if (InWorld.GetNetMode() != NM_Client && FParse::Param(FCommandLine::Get(), TEXT("VRiCCSoak")))
+	{
+		double Duration = 0.0;
+		FParse::Value(FCommandLine::Get(), TEXT("VRiCCSoakDuration="), Duration);
+		StartSoak(Duration);
+	}
+}
+
+void UVRiCCSoakReportSubsystem::StartSoak(double Duration)
+{
+	Intervals.Reset();
+	FrameMs.Reset();
+	OutBytesPerConnectionSum = 0.0;
+	InBytesPerConnectionSum = 0.0;
+	OutBytesPerConnectionMax = 0.f;
+	NumConnectionSamples = 0;
+	NumGCs = 0;
+	GCMsTotal = 0.f;
+	GCMsMax = 0.f;
+
+	StartSeconds = FPlatformTime::Seconds();
+	IntervalStartSeconds = StartSeconds;
+	EndSeconds = Duration > 0.0 ? StartSeconds + Duration : 0.0;
+	bRunning = true;
+
+	UE_LOG(LogTemp, Display, TEXT("Soak: started%s"), Duration > 0.0 ? *FString::Printf(TEXT(" for %.0fs"), Duration) : TEXT(""));
+}
+
+void UVRiCCSoakReportSubsystem::Tick(float DeltaTime)
+{
+	FrameMs.Add(float((FApp::GetDeltaTime() - FApp::GetIdleTime()) * 1000.0));
+
+	if (const UNetDriver* NetDriver = GetWorld()->GetNetDriver())
+	{
+		NumConnections = NetDriver->ClientConnections.Num();
+		for (const UNetConnection* Connection : NetDriver->ClientConnections)
+		{
+			OutBytesPerConnectionSum += Connection->OutBytesPerSecond;
+			InBytesPerConnectionSum += Connection->InBytesPerSecond;
+			OutBytesPerConnectionMax = FMath::Max(OutBytesPerConnectionMax, float(Connection->OutBytesPerSecond));
+			NumConnectionSamples++;
+		}
+	}
+
+	const double Now = FPlatformTime::Seconds();
+	if (Now - IntervalStartSeconds >= FMath::Max(CVarSoakInterval.GetValueOnGameThread(), 1.f))
+	{
+		CloseInterval();
+	}
+
+	if (EndSeconds > 0.0 && Now >= EndSeconds)
+	{
+		StopSoak();
+		FPlatformMisc::RequestExit(false);
+	}
+}
+
+void UVRiCCSoakReportSubsystem::CloseInterval()
+{
+	if (FrameMs.Num() == 0)
+	{
+		return;
+	}
+
+	FVRiCCSoakInterval& Interval = Intervals.AddDefaulted_GetRef();
+	Interval.EndSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+	double FrameMsSum = 0.0;
+	for (float Ms : FrameMs)
+	{
+		FrameMsSum += Ms;
+	}
+	FrameMs.Sort();
+	Interval.FrameMsAvg = float(FrameMsSum / FrameMs.Num());
+	Interval.FrameMsP95 = FrameMs[FMath::Min(int32(FrameMs.Num() * 0.95f), FrameMs.Num() - 1)];
+	Interval.FrameMsMax = FrameMs.Last();
+
+	Interval.NumConnections = NumConnections;
+	if (NumConnectionSamples > 0)
+	{
+		Interval.OutBytesPerConnectionAvg = float(OutBytesPerConnectionSum / NumConnectionSamples);
+		Interval.InBytesPerConnectionAvg = float(InBytesPerConnectionSum / NumConnectionSamples);
+		Interval.OutBytesPerConnectionMax = OutBytesPerConnectionMax;
+	}
+
+	Interval.NumGCs = NumGCs;
+	Interval.GCMsTotal = GCMsTotal;
+	Interval.GCMsMax = GCMsMax;
+	Interval.NumObjects = GUObjectArray.GetObjectArrayNumMinusAvailable();
+
+	UE_LOG(LogTemp, Display, TEXT("Soak %.0fs: frame avg %.2fms p95 %.2fms max %.2fms, %d connections out %.0f B/s avg %.0f B/s max in %.0f B/s, GC %d runs %.1fms max %.1fms, %d objects"),
+		Interval.EndSeconds, Interval.FrameMsAvg, Interval.FrameMsP95, Interval.FrameMsMax,
+		Interval.NumConnections, Interval.OutBytesPerConnectionAvg, Interval.OutBytesPerConnectionMax, Interval.InBytesPerConnectionAvg,
+		Interval.NumGCs, Interval.GCMsTotal, Interval.GCMsMax, Interval.NumObjects);
+
+	FrameMs.Reset();
+	OutBytesPerConnectionSum = 0.0;
+	InBytesPerConnectionSum = 0.0;
+	OutBytesPerConnectionMax = 0.f;
+	NumConnectionSamples = 0;
+	NumGCs = 0;
+	GCMsTotal = 0.f;
+	GCMsMax = 0.f;
+	IntervalStartSeconds = FPlatformTime::Seconds();
+}
+
+FString UVRiCCSoakReportSubsystem::StopSoak()
+{
+	if (!bRunning)
+	{
+		return FString();
+	}
+
+	CloseInterval();
+	bRunning = false;
+
+	FString Csv = TEXT("Seconds,FrameMsAvg,FrameMsP95,FrameMsMax,Connections,OutBytesPerConnectionAvg,OutBytesPerConnectionMax,InBytesPerConnectionAvg,GCs,GCMsTotal,GCMsMax,Objects\n");
+	for (const FVRiCCSoakInterval& Interval : Intervals)
+	{
+		Csv += FString::Printf(TEXT("%.1f,%.3f,%.3f,%.3f,%d,%.0f,%.0f,%.0f,%d,%.2f,%.2f,%d\n"),
+			Interval.EndSeconds, Interval.FrameMsAvg, Interval.FrameMsP95, Interval.FrameMsMax,
+			Interval.NumConnections, Interval.OutBytesPerConnectionAvg, Interval.OutBytesPerConnectionMax, Interval.InBytesPerConnectionAvg,
+			Interval.NumGCs, Interval.GCMsTotal, Interval.GCMsMax, Interval.NumObjects);
+	}
+
+	const FString Path = FPaths::ProjectSavedDir() / TEXT("Soak") / FString::Printf(TEXT("Soak-%s.csv"), *FDateTime::Now().ToString());
+	if (FFileHelper::SaveStringToFile(Csv, *Path))
+	{
+		UE_LOG(LogTemp, Display, TEXT("Soak: %d intervals written to %s"), Intervals.Num(), *Path);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Warning, TEXT("Soak: could not write %s"), *Path);
+	}
+	return Path;
+}
+
+void UVRiCCSoakReportSubsystem::OnPreGarbageCollect()
+{
+	GCStartSeconds = FPlatformTime::Seconds();
+}
+
+void UVRiCCSoakReportSubsystem::OnPostGarbageCollect()
+{
+	if (bRunning && GCStartSeconds > 0.0)
+	{
+		const float Ms = float((FPlatformTime::Seconds() - GCStartSeconds) * 1000.0);
+		NumGCs++;
+		GCMsTotal += Ms;
+		GCMsMax = FMath::Max(GCMsMax, Ms);
+	}
+	GCStartSeconds = 0.0;
+}
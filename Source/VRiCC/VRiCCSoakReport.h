@@ -0,0 +1,93 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCSoakReport.generated.h"
+
+/** Server health over one report interval of a soak run */
+struct FVRiCCSoakInterval
+{
+	double EndSeconds = 0.0;
+	float FrameMsAvg = 0.f;
+	float FrameMsP95 = 0.f;
+	float FrameMsMax = 0.f;
+	int32 NumConnections = 0;
+	float OutBytesPerConnectionAvg = 0.f;
+	float OutBytesPerConnectionMax = 0.f;
+	float InBytesPerConnectionAvg = 0.f;
+	int32 NumGCs = 0;
+	float GCMsTotal = 0.f;
+	float GCMsMax = 0.f;
+	int32 NumObjects = 0;
+};
+
+/**
+ * Measures a server under load, started with -VRiCCSoak or VRiCC.Soak.Start.
+ * Every VRiCC.Soak.Interval seconds it logs frame time, per connection bandwidth and garbage
+ * collection, and writes all intervals to Saved/Soak/ as CSV when the run ends.
+ * -VRiCCSoakDuration=N ends the run and quits after N seconds, for unattended runs of the bot launcher.
+ */
+UCLASS()
+class VRICC_API UVRiCCSoakReportSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// USubsystem interface
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+	// End of USubsystem interface
+
+	// UWorldSubsystem interface
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	// End of UWorldSubsystem interface
+
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return bRunning; }
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	void StartSoak(double Duration);
+
+	/** Ends the run and writes the CSV, returns its path */
+	FString StopSoak();
+
+	bool IsRunning() const { return bRunning; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void CloseInterval();
+
+	void OnPreGarbageCollect();
+	void OnPostGarbageCollect();
+
+	TArray<FVRiCCSoakInterval> Intervals;
+
+	/** Game thread time of every frame of the open interval in ms, without the idle wait for the next server tick */
+	TArray<float> FrameMs;
+
+	/** Sums over the ticks of the open interval */
+	double OutBytesPerConnectionSum = 0.0;
+	double InBytesPerConnectionSum = 0.0;
+	float OutBytesPerConnectionMax = 0.f;
+	int32 NumConnectionSamples = 0;
+	int32 NumConnections = 0;
+
+	int32 NumGCs = 0;
+	float GCMsTotal = 0.f;
+	float GCMsMax = 0.f;
+	double GCStartSeconds = 0.0;
+
+	double StartSeconds = 0.0;
+	double IntervalStartSeconds = 0.0;
+	double EndSeconds = 0.0;
+	bool bRunning = false;
+
+	FDelegateHandle PreGCHandle;
+	FDelegateHandle PostGCHandle;
+};
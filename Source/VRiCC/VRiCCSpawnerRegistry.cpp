@@ -0,0 +1,147 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCSpawnerRegistry.h"
+#include "WeaponSpawner.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+/** Resolution of the spawner timer wheel, events fire on the first frame after their 1/30s tick */
+static constexpr double SpawnerTimerResolution = 1.0 / 30.0;
+
+static FAutoConsoleCommandWithWorld GSpawnerStatsCommand(
+	TEXT("VRiCC.Spawners.Stats"),
+	TEXT("Prints registered spawners and scheduled versus fired spawner events."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCSpawnerRegistry* SpawnerRegistry = World != nullptr ? World->GetSubsystem<UVRiCCSpawnerRegistry>() : nullptr)
+		{
+			UE_LOG(LogTemp, Display, TEXT("Spawners: %d registered, events scheduled %llu, fired %llu, pending %d"),
+				SpawnerRegistry->GetNumSpawners(), SpawnerRegistry->GetNumScheduledEvents(), SpawnerRegistry->GetNumFiredEvents(), SpawnerRegistry->GetNumPendingEvents());
+		}
+	}));
+
+bool UVRiCCSpawnerRegistry::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UVRiCCSpawnerRegistry::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCSpawnerRegistry, STATGROUP_Tickables);
+}
+
+bool UVRiCCSpawnerRegistry::IsTickable() const
+{
+	// idle maps with no pending respawns cost nothing per frame
+	return Timers.Num() > 0;
+}
+
+uint64 UVRiCCSpawnerRegistry::GetWorldTick() const
+{
+	return uint64(GetWorld()->GetTimeSeconds() / SpawnerTimerResolution);
+}
+
+void UVRiCCSpawnerRegistry::Tick(float DeltaTime)
+{
+	FireDueEvents(GetWorldTick());
+}
+
+void UVRiCCSpawnerRegistry::FireDueEvents(uint64 Tick)
+{
+	Timers.AdvanceTo(Tick, [this](const FVRiCCSpawnerTimer& Timer)
+	{
+		NumFiredEvents++;
+
+		// spawners that went away since scheduling simply do not resolve any more
+		if (AWeaponSpawner* Spawner = Resolve(Timer.Spawner))
+		{
+			Spawner->HandleSpawnerEvent(Timer.Event);
+		}
+	});
+}
+
+FVRiCCTimerWheelHandle UVRiCCSpawnerRegistry::ScheduleEvent(const FVRiCCSpawnerHandle& Spawner, EVRiCCSpawnerEvent Event, float Delay)
+{
+	// nothing advanced the wheel while it was empty, catch it up without walking the idle ticks
+	const uint64 Now = GetWorldTick();
+	if (Timers.Num() == 0)
+	{
+		Timers.ResetCurrentTick(Now);
+	}
+	else
+	{
+		FireDueEvents(Now);
+	}
+
+	NumScheduledEvents++;
+	const uint64 DelayTicks = uint64(FMath::CeilToDouble(FMath::Max(Delay, 0.f) / SpawnerTimerResolution));
+	return Timers.Schedule(DelayTicks, FVRiCCSpawnerTimer{ Spawner, Event });
+}
+
+void UVRiCCSpawnerRegistry::CancelEvent(const FVRiCCTimerWheelHandle& Timer)
+{
+	Timers.Cancel(Timer);
+}
+
+FVRiCCSpawnerHandle UVRiCCSpawnerRegistry::Register(AWeaponSpawner* Spawner)
+{
+	FVRiCCSpawnerHandle Handle;
+	if (Spawner == nullptr)
+	{
+		return Handle;
+	}
+
+	if (FreeSlots.Num() > 0)
+	{
+		Handle.Index = FreeSlots.Pop(false);
+		Spawners[Handle.Index] = Spawner;
+	}
+	else
+	{
+		Handle.Index = Spawners.Add(Spawner);
+		Serials.Add(0);
+	}
+
+	Handle.Serial = ++Serials[Handle.Index];
+	return Handle;
+}
+
+void UVRiCCSpawnerRegistry::Unregister(const FVRiCCSpawnerHandle& Handle)
+{
+	if (Resolve(Handle) != nullptr)
+	{
+		Spawners[Handle.Index] = nullptr;
+		Serials[Handle.Index]++;
+		FreeSlots.Add(Handle.Index);
+	}
+}
+
+AWeaponSpawner* UVRiCCSpawnerRegistry::Resolve(const FVRiCCSpawnerHandle& Handle) const
+{
+	if (Spawners.IsValidIndex(Handle.Index) && Serials[Handle.Index] == Handle.Serial)
+	{
+		return Spawners[Handle.Index];
+	}
+	return nullptr;
+}
+
+FVRiCCSpawnerHandle UVRiCCSpawnerRegistry::FindNearest(const FVector& Location) const
+{
+	FVRiCCSpawnerHandle Nearest;
+	double NearestDistSq = TNumericLimits<double>::Max();
+
+	for (int32 Index = 0; Index < Spawners.Num(); ++Index)
+	{
+		if (const AWeaponSpawner* Spawner = Spawners[Index])
+		{
+			const double DistSq = FVector::DistSquared(Spawner->GetActorLocation(), Location);
+			if (DistSq < NearestDistSq)
+			{
+				NearestDistSq = DistSq;
+				Nearest.Index = Index;
+				Nearest.Serial = Serials[Index];
+			}
+		}
+	}
+	return Nearest;
+}
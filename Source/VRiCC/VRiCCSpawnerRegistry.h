@@ -0,0 +1,97 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "VRiCCTimerWheel.h"
+#include "VRiCCSpawnerRegistry.generated.h"
+
+class AWeaponSpawner;
+
+/** Stable reference to a registered spawner, goes stale when the spawner unregisters */
+USTRUCT(BlueprintType)
+struct FVRiCCSpawnerHandle
+{
+	GENERATED_BODY()
+
+	int32 Index = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Index != INDEX_NONE; }
+	void Invalidate() { Index = INDEX_NONE; Serial = 0; }
+};
+
+/** Timed events a spawner can schedule */
+enum class EVRiCCSpawnerEvent : uint8
+{
+	Respawn,
+	CooldownFinished,
+};
+
+/** What the timer wheel fires: which spawner and what happens to it */
+struct FVRiCCSpawnerTimer
+{
+	FVRiCCSpawnerHandle Spawner;
+	EVRiCCSpawnerEvent Event = EVRiCCSpawnerEvent::Respawn;
+};
+
+/**
+ * Every AWeaponSpawner of the world, stored in slots that are reused after unregistering.
+ * Handles carry the slot serial, so resolving one is a bounds check and a compare.
+ * Spawners do not tick, their respawn and cooldown events run off one timer wheel owned by the registry,
+ * and the registry itself only ticks while timers are pending.
+ */
+UCLASS()
+class VRICC_API UVRiCCSpawnerRegistry : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	FVRiCCSpawnerHandle Register(AWeaponSpawner* Spawner);
+	void Unregister(const FVRiCCSpawnerHandle& Handle);
+
+	/** O(1) lookup, null if the handle is stale */
+	AWeaponSpawner* Resolve(const FVRiCCSpawnerHandle& Handle) const;
+
+	/** Closest registered spawner to Location, for pickups that were not spawned by a spawner */
+	FVRiCCSpawnerHandle FindNearest(const FVector& Location) const;
+
+	int32 GetNumSpawners() const { return Spawners.Num() - FreeSlots.Num(); }
+
+	/** Sends Event to the spawner after Delay seconds, rounded up to the wheel resolution */
+	FVRiCCTimerWheelHandle ScheduleEvent(const FVRiCCSpawnerHandle& Spawner, EVRiCCSpawnerEvent Event, float Delay);
+	void CancelEvent(const FVRiCCTimerWheelHandle& Timer);
+
+	int32 GetNumPendingEvents() const { return Timers.Num(); }
+	uint64 GetNumScheduledEvents() const { return NumScheduledEvents; }
+	uint64 GetNumFiredEvents() const { return NumFiredEvents; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<AWeaponSpawner>> Spawners;
+
+	/** Bumped every time a slot is reused so old handles stop resolving */
+	TArray<uint32> Serials;
+
+	TArray<int32> FreeSlots;
+
+	/** Wheel tick the current world time falls into */
+	uint64 GetWorldTick() const;
+
+	void FireDueEvents(uint64 Tick);
+
+	TVRiCCTimerWheel<FVRiCCSpawnerTimer> Timers;
+
+	uint64 NumScheduledEvents = 0;
+	uint64 NumFiredEvents = 0;
+};
@@ -0,0 +1,26 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCStats.h"
+
+DEFINE_STAT(STAT_VRiCC_FireShots);
+DEFINE_STAT(STAT_VRiCC_ResolveShotPacket);
+DEFINE_STAT(STAT_VRiCC_ShotsTraced);
+DEFINE_STAT(STAT_VRiCC_TraceQueue);
+DEFINE_STAT(STAT_VRiCC_ShotResolver);
+DEFINE_STAT(STAT_VRiCC_LagCompensation);
+DEFINE_STAT(STAT_VRiCC_TakeDamage);
+DEFINE_STAT(STAT_VRiCC_ApplyDamage);
+DEFINE_STAT(STAT_VRiCC_PickupOverlap);
+DEFINE_STAT(STAT_VRiCC_HUDFlush);
+DEFINE_STAT(STAT_VRiCC_Projectiles);
+DEFINE_STAT(STAT_VRiCC_ImpactEffects);
+DEFINE_STAT(STAT_VRiCC_WeaponAudio);
+
+DEFINE_STAT(STAT_VRiCC_Shots);
+DEFINE_STAT(STAT_VRiCC_Traces);
+DEFINE_STAT(STAT_VRiCC_Hits);
+DEFINE_STAT(STAT_VRiCC_DamageEvents);
+DEFINE_STAT(STAT_VRiCC_HUDPushes);
+DEFINE_STAT(STAT_VRiCC_ProjectilesAlive);
+
+CSV_DEFINE_CATEGORY_MODULE(VRICC_API, VRiCC, true);
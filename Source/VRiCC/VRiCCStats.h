@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
+
+/**
+ * Instrumentation of the gameplay hot paths: "stat VRiCC" in game, Unreal Insights, and the VRiCC category
+ * of the CSV profiler, which a headless server captures with -csvCategories=VRiCC -csvCaptureFrames=N
+ * or "CsvProfile Start". Everything here compiles to nothing in shipping builds.
+ */
+DECLARE_STATS_GROUP(TEXT("VRiCC"), STATGROUP_VRiCC, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Fire Shots"), STAT_VRiCC_FireShots, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Resolve Shot Packet"), STAT_VRiCC_ResolveShotPacket, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shots Traced"), STAT_VRiCC_ShotsTraced, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Trace Queue"), STAT_VRiCC_TraceQueue, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Shot Resolver"), STAT_VRiCC_ShotResolver, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Lag Compensation"), STAT_VRiCC_LagCompensation, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Take Damage"), STAT_VRiCC_TakeDamage, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Apply Damage"), STAT_VRiCC_ApplyDamage, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pickup Overlap"), STAT_VRiCC_PickupOverlap, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("HUD Flush"), STAT_VRiCC_HUDFlush, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectiles"), STAT_VRiCC_Projectiles, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Impact Effects"), STAT_VRiCC_ImpactEffects, STATGROUP_VRiCC, VRICC_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Weapon Audio"), STAT_VRiCC_WeaponAudio, STATGROUP_VRiCC, VRICC_API);
+
+/** Cleared every frame */
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Shots"), STAT_VRiCC_Shots, STATGROUP_VRiCC, VRICC_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces"), STAT_VRiCC_Traces, STATGROUP_VRiCC, VRICC_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hits"), STAT_VRiCC_Hits, STATGROUP_VRiCC, VRICC_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Events"), STAT_VRiCC_DamageEvents, STATGROUP_VRiCC, VRICC_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("HUD Pushes"), STAT_VRiCC_HUDPushes, STATGROUP_VRiCC, VRICC_API);
+
+/** Set to the current value */
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Projectiles Alive"), STAT_VRiCC_ProjectilesAlive, STATGROUP_VRiCC, VRICC_API);
+
+CSV_DECLARE_CATEGORY_MODULE_EXTERN(VRICC_API, VRiCC);
+
+#if UE_BUILD_SHIPPING
+
+#define VRICC_SCOPE_CYCLE(Name)
+#define VRICC_COUNT(Name, Amount)
+#define VRICC_SET(Name, Value)
+
+#else
+
+/** Times the enclosing scope as STAT_VRiCC_<Name> and as the CSV stat <Name> */
+#if STATS
+// cycle counters already show up in Insights while stats are compiled in
+#define VRICC_SCOPE_CYCLE(Name) \
+	SCOPE_CYCLE_COUNTER(STAT_VRiCC_##Name); \
+	CSV_SCOPED_TIMING_STAT(VRiCC, Name)
+#else
+#define VRICC_SCOPE_CYCLE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(VRiCC_##Name); \
+	CSV_SCOPED_TIMING_STAT(VRiCC, Name)
+#endif
+
+/** Adds Amount to the per frame counter STAT_VRiCC_<Name> and the CSV stat <Name> */
+#define VRICC_COUNT(Name, Amount) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(STAT_VRiCC_##Name, Amount); \
+		CSV_CUSTOM_STAT(VRiCC, Name, int32(Amount), ECsvCustomStatOp::Accumulate); \
+	} while (0)
+
+/** Sets STAT_VRiCC_<Name> and the CSV stat <Name> to Value */
+#define VRICC_SET(Name, Value) \
+	do \
+	{ \
+		SET_DWORD_STAT(STAT_VRiCC_##Name, Value); \
+		CSV_CUSTOM_STAT(VRiCC, Name, int32(Value), ECsvCustomStatOp::Set); \
+	} while (0)
+
+#endif
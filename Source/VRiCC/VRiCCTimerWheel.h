@@ -0,0 +1,187 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Timer scheduled on a TVRiCCTimerWheel, goes stale once the timer fired or was cancelled */
+struct FVRiCCTimerWheelHandle
+{
+	int32 Node = INDEX_NONE;
+	uint32 Serial = 0;
+
+	bool IsValid() const { return Node != INDEX_NONE; }
+	void Invalidate() { Node = INDEX_NONE; Serial = 0; }
+};
+
+/**
+ * Hierarchical timer wheel with 4 levels of 64 slots.
+ * Scheduling and cancelling are O(1), advancing costs one slot check per elapsed tick plus the
+ * timers that fire or cascade down a level. Timer nodes are pooled so steady state use never allocates.
+ */
+template<typename PayloadType>
+class TVRiCCTimerWheel
+{
+public:
+	static constexpr int32 SlotBits = 6;
+	static constexpr int32 NumSlots = 1 << SlotBits;
+	static constexpr int32 NumLevels = 4;
+	static constexpr uint64 MaxDelay = (uint64(1) << (SlotBits * NumLevels)) - 1;
+
+	TVRiCCTimerWheel()
+	{
+		for (int32 Level = 0; Level < NumLevels; ++Level)
+		{
+			for (int32 Slot = 0; Slot < NumSlots; ++Slot)
+			{
+				Heads[Level][Slot] = INDEX_NONE;
+			}
+		}
+	}
+
+	uint64 GetCurrentTick() const { return CurrentTick; }
+	int32 Num() const { return NumPending; }
+
+	/** Only valid while no timers are pending, used to skip idle time without walking the slots */
+	void ResetCurrentTick(uint64 Tick)
+	{
+		check(NumPending == 0);
+		CurrentTick = Tick;
+	}
+
+	/** Fires Payload after DelayTicks, a delay of 0 fires on the next Advance */
+	FVRiCCTimerWheelHandle Schedule(uint64 DelayTicks, const PayloadType& Payload)
+	{
+		int32 NodeIndex = FreeList;
+		if (NodeIndex != INDEX_NONE)
+		{
+			FreeList = Nodes[NodeIndex].Next;
+		}
+		else
+		{
+			NodeIndex = Nodes.AddDefaulted();
+		}
+
+		FNode& Node = Nodes[NodeIndex];
+		Node.Expiry = CurrentTick + FMath::Clamp<uint64>(DelayTicks, 1, MaxDelay);
+		Node.Payload = Payload;
+		Node.bPending = true;
+		Insert(NodeIndex);
+
+		NumPending++;
+		return FVRiCCTimerWheelHandle{ NodeIndex, Node.Serial };
+	}
+
+	/** Cancelled timers stay linked until their slot is reached, they are just not fired */
+	bool Cancel(const FVRiCCTimerWheelHandle& Handle)
+	{
+		if (Nodes.IsValidIndex(Handle.Node) && Nodes[Handle.Node].Serial == Handle.Serial && Nodes[Handle.Node].bPending)
+		{
+			Nodes[Handle.Node].bPending = false;
+			NumPending--;
+			return true;
+		}
+		return false;
+	}
+
+	/** Moves time forward to TargetTick, calling OnFire(Payload) for every timer due on the way */
+	template<typename FireFunc>
+	void AdvanceTo(uint64 TargetTick, FireFunc&& OnFire)
+	{
+		while (CurrentTick < TargetTick)
+		{
+			CurrentTick++;
+
+			// a lower level wrapped around, pull the next block of timers down from the level above
+			for (int32 Level = NumLevels - 1; Level > 0; --Level)
+			{
+				const uint64 LevelMask = (uint64(1) << (SlotBits * Level)) - 1;
+				if ((CurrentTick & LevelMask) == 0)
+				{
+					Cascade(Level, int32((CurrentTick >> (SlotBits * Level)) & (NumSlots - 1)));
+				}
+			}
+
+			const int32 Slot = int32(CurrentTick & (NumSlots - 1));
+			int32 NodeIndex = Heads[0][Slot];
+			Heads[0][Slot] = INDEX_NONE;
+			while (NodeIndex != INDEX_NONE)
+			{
+				const int32 Next = Nodes[NodeIndex].Next;
+				if (Nodes[NodeIndex].bPending)
+				{
+					NumPending--;
+					const PayloadType Payload = Nodes[NodeIndex].Payload;
+					Release(NodeIndex);
+					// may schedule new timers, NodeIndex is already back in the free list
+					OnFire(Payload);
+				}
+				else
+				{
+					Release(NodeIndex);
+				}
+				NodeIndex = Next;
+			}
+		}
+	}
+
+private:
+	struct FNode
+	{
+		uint64 Expiry = 0;
+		PayloadType Payload;
+		int32 Next = INDEX_NONE;
+		uint32 Serial = 0;
+		bool bPending = false;
+	};
+
+	void Insert(int32 NodeIndex)
+	{
+		FNode& Node = Nodes[NodeIndex];
+		const uint64 Delta = Node.Expiry > CurrentTick ? Node.Expiry - CurrentTick : 0;
+
+		int32 Level = 0;
+		while (Level < NumLevels - 1 && Delta >= (uint64(1) << (SlotBits * (Level + 1))))
+		{
+			Level++;
+		}
+
+		const int32 Slot = int32((Node.Expiry >> (SlotBits * Level)) & (NumSlots - 1));
+		Node.Next = Heads[Level][Slot];
+		Heads[Level][Slot] = NodeIndex;
+	}
+
+	void Cascade(int32 Level, int32 Slot)
+	{
+		int32 NodeIndex = Heads[Level][Slot];
+		Heads[Level][Slot] = INDEX_NONE;
+		while (NodeIndex != INDEX_NONE)
+		{
+			const int32 Next = Nodes[NodeIndex].Next;
+			if (Nodes[NodeIndex].bPending)
+			{
+				Insert(NodeIndex);
+			}
+			else
+			{
+				Release(NodeIndex);
+			}
+			NodeIndex = Next;
+		}
+	}
+
+	void Release(int32 NodeIndex)
+	{
+		FNode& Node = Nodes[NodeIndex];
+		Node.bPending = false;
+		Node.Serial++;
+		Node.Next = FreeList;
+		FreeList = NodeIndex;
+	}
+
+	TArray<FNode> Nodes;
+	int32 Heads[NumLevels][NumSlots];
+	int32 FreeList = INDEX_NONE;
+	int32 NumPending = 0;
+	uint64 CurrentTick = 0;
+};
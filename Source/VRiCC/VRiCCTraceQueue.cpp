@@ -0,0 +1,173 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCTraceQueue.h"
+#include "TP_WeaponComponent.h"
+#include "VRiCCShotResolver.h"
+#include "VRiCCStats.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarTraceQueueLogStats(
+	TEXT("VRiCC.TraceQueue.LogStats"),
+	false,
+	TEXT("Logs the weapon trace queue counters every frame traces were submitted or delivered."));
+
+static FAutoConsoleCommandWithWorld GTraceQueueStatsCommand(
+	TEXT("VRiCC.TraceQueue.Stats"),
+	TEXT("Prints the weapon trace queue counters."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCTraceQueueSubsystem* TraceQueue = World != nullptr ? World->GetSubsystem<UVRiCCTraceQueueSubsystem>() : nullptr)
+		{
+			const FVRiCCTraceQueueStats& Stats = TraceQueue->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("TraceQueue: total %llu, peak %d/frame, avg latency %.2fms, last frame submitted %d delivered %d dropped %d, game thread %.3fms"),
+				Stats.TotalTraces, Stats.PeakPerFrame, Stats.AverageLatencyMs, Stats.SubmittedLastFrame, Stats.DeliveredLastFrame, Stats.DroppedLastFrame, Stats.GameThreadMs);
+		}
+	}));
+
+bool UVRiCCTraceQueueSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UVRiCCTraceQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UVRiCCTraceQueueSubsystem, STATGROUP_Tickables);
+}
+
+void UVRiCCTraceQueueSubsystem::EnqueueShot(UTP_WeaponComponent* Weapon, AActor* IgnoreActor, const FVector& Start, const FVector& End, double ShotTime, bool bServerValidation)
+{
+	FVRiCCShotTrace& Shot = Pending.AddDefaulted_GetRef();
+	Shot.Weapon = Weapon;
+	Shot.IgnoreActor = IgnoreActor;
+	Shot.Start = Start;
+	Shot.End = End;
+	Shot.ShotTime = ShotTime;
+	Shot.bServerValidation = bServerValidation;
+}
+
+void UVRiCCTraceQueueSubsystem::EnqueueShots(UTP_WeaponComponent* Weapon, AActor* IgnoreActor, const FVector& Start, const FVector& End, TConstArrayView<double> ShotTimes, bool bServerValidation)
+{
+	// consecutive so DeliverResults hands them back as one run
+	Pending.Reserve(Pending.Num() + ShotTimes.Num());
+	for (double ShotTime : ShotTimes)
+	{
+		EnqueueShot(Weapon, IgnoreActor, Start, End, ShotTime, bServerValidation);
+	}
+}
+
+void UVRiCCTraceQueueSubsystem::Tick(float DeltaTime)
+{
+	VRICC_SCOPE_CYCLE(TraceQueue);
+
+	const double StartSeconds = FPlatformTime::Seconds();
+
+	// last frame's batch first, then kick off this frame's so its results are ready next frame
+	DeliverResults();
+	SubmitPending();
+
+	Stats.GameThreadMs = (FPlatformTime::Seconds() - StartSeconds) * 1000.0;
+
+	if (CVarTraceQueueLogStats.GetValueOnGameThread() && (Stats.SubmittedLastFrame > 0 || Stats.DeliveredLastFrame > 0))
+	{
+		UE_LOG(LogTemp, Log, TEXT("TraceQueue: submitted %d delivered %d dropped %d, latency %.2fms, game thread %.3fms"),
+			Stats.SubmittedLastFrame, Stats.DeliveredLastFrame, Stats.DroppedLastFrame, Stats.AverageLatencyMs, Stats.GameThreadMs);
+	}
+}
+
+void UVRiCCTraceQueueSubsystem::DeliverResults()
+{
+	Stats.DeliveredLastFrame = 0;
+	Stats.DroppedLastFrame = 0;
+
+	if (InFlight.Num() == 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	// drop shots whose weapon went away or whose result is missing, keeping the order of the rest
+	FTraceDatum Datum;
+	int32 NumDelivered = 0;
+	for (FVRiCCShotTrace& Shot : InFlight)
+	{
+		if (!Shot.Weapon.IsValid() || !World->QueryTraceData(Shot.Handle, Datum))
+		{
+			Stats.DroppedLastFrame++;
+			continue;
+		}
+
+		Shot.bHasHit = Datum.OutHits.Num() > 0;
+		if (Shot.bHasHit)
+		{
+			Shot.Hit = Datum.OutHits[0];
+		}
+
+		if (&Shot != &InFlight[NumDelivered])
+		{
+			InFlight[NumDelivered] = MoveTemp(Shot);
+		}
+		NumDelivered++;
+	}
+	Stats.DeliveredLastFrame = NumDelivered;
+
+	// one call per run of shots from the same weapon
+	int32 RunStart = 0;
+	while (RunStart < NumDelivered)
+	{
+		UTP_WeaponComponent* Weapon = InFlight[RunStart].Weapon.Get();
+		int32 RunEnd = RunStart + 1;
+		while (RunEnd < NumDelivered && InFlight[RunEnd].Weapon.Get() == Weapon)
+		{
+			RunEnd++;
+		}
+
+		Weapon->OnShotsTraced(TConstArrayView<FVRiCCShotTrace>(InFlight.GetData() + RunStart, RunEnd - RunStart));
+		RunStart = RunEnd;
+	}
+
+	// server validation shots handed over above are resolved as one parallel batch
+	if (UVRiCCShotResolverSubsystem* ShotResolver = World->GetSubsystem<UVRiCCShotResolverSubsystem>())
+	{
+		ShotResolver->ResolvePending();
+	}
+
+	// all shots of a batch share the submit time, so one sample per frame is enough
+	const double LatencyMs = (NowSeconds - InFlight[0].SubmitSeconds) * 1000.0;
+	Stats.AverageLatencyMs = Stats.AverageLatencyMs > 0.0 ? FMath::Lerp(Stats.AverageLatencyMs, LatencyMs, 0.1) : LatencyMs;
+
+	// keep the allocation for the next batch
+	InFlight.Reset();
+}
+
+void UVRiCCTraceQueueSubsystem::SubmitPending()
+{
+	Stats.SubmittedLastFrame = Pending.Num();
+	if (Pending.Num() == 0)
+	{
+		return;
+	}
+
+	UWorld* World = GetWorld();
+	const double NowSeconds = FPlatformTime::Seconds();
+
+	// world geometry only, characters are tested against their hitboxes by the lag compensation subsystem
+	FCollisionResponseParams WorldResponse;
+	WorldResponse.CollisionResponse.SetResponse(ECC_Pawn, ECR_Ignore);
+
+	for (FVRiCCShotTrace& Shot : Pending)
+	{
+		const FCollisionQueryParams CollisionParams(SCENE_QUERY_STAT(VRiCCWeaponTrace), false, Shot.IgnoreActor.Get());
+		Shot.Handle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Shot.Start, Shot.End, ECollisionChannel::ECC_GameTraceChannel1, CollisionParams, WorldResponse);
+		Shot.SubmitSeconds = NowSeconds;
+	}
+
+	Stats.TotalTraces += Pending.Num();
+	VRICC_COUNT(Traces, Pending.Num());
+	Stats.PeakPerFrame = FMath::Max(Stats.PeakPerFrame, Pending.Num());
+
+	// InFlight is empty after DeliverResults, so this hands both allocations over without copying
+	Swap(InFlight, Pending);
+}
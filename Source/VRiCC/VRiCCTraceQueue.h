@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "WorldCollision.h"
+#include "VRiCCTraceQueue.generated.h"
+
+class UTP_WeaponComponent;
+
+/** One weapon trace waiting for its asynchronous result */
+struct FVRiCCShotTrace
+{
+	TWeakObjectPtr<UTP_WeaponComponent> Weapon;
+	TWeakObjectPtr<AActor> IgnoreActor;
+	FVector Start = FVector::ZeroVector;
+	FVector End = FVector::ZeroVector;
+
+	/** Server time the shot was fired at, used to rewind hitboxes */
+	double ShotTime = 0.0;
+
+	/** Server validation shot, its hitbox test is done by the shot resolver against rewound hitboxes */
+	bool bServerValidation = false;
+
+	FTraceHandle Handle;
+	double SubmitSeconds = 0.0;
+
+	/** Filled in when the result is delivered, only valid if bHasHit */
+	FHitResult Hit;
+	bool bHasHit = false;
+
+	/** Null if the trace hit nothing */
+	const FHitResult* GetHit() const { return bHasHit ? &Hit : nullptr; }
+};
+
+/** Counters of the trace queue, "last frame" values are overwritten every tick */
+struct FVRiCCTraceQueueStats
+{
+	int32 SubmittedLastFrame = 0;
+	int32 DeliveredLastFrame = 0;
+	int32 DroppedLastFrame = 0;
+	int32 PeakPerFrame = 0;
+	uint64 TotalTraces = 0;
+
+	/** Moving average of the time from submitting a batch to handing out its results */
+	double AverageLatencyMs = 0.0;
+
+	/** Game thread time spent submitting and delivering last frame */
+	double GameThreadMs = 0.0;
+};
+
+/**
+ * Collects every weapon trace requested during a frame and submits them as one batch
+ * through the async trace API. Results are handed back to the weapons the next frame,
+ * one OnShotsTraced call per run of consecutive shots of the same weapon.
+ */
+UCLASS()
+class VRICC_API UVRiCCTraceQueueSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// FTickableGameObject interface
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+	// End of FTickableGameObject interface
+
+	/** Queues a weapon trace on ECC_GameTraceChannel1, the weapon gets OnShotsTraced next frame */
+	void EnqueueShot(UTP_WeaponComponent* Weapon, AActor* IgnoreActor, const FVector& Start, const FVector& End, double ShotTime, bool bServerValidation);
+
+	/** Queues one trace per shot time along the same line, delivered back to the weapon in a single OnShotsTraced call */
+	void EnqueueShots(UTP_WeaponComponent* Weapon, AActor* IgnoreActor, const FVector& Start, const FVector& End, TConstArrayView<double> ShotTimes, bool bServerValidation);
+
+	const FVRiCCTraceQueueStats& GetStats() const { return Stats; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void DeliverResults();
+	void SubmitPending();
+
+	/** Requested this frame, submitted at the end of the frame */
+	TArray<FVRiCCShotTrace> Pending;
+
+	/** Submitted last frame, results become available this frame */
+	TArray<FVRiCCShotTrace> InFlight;
+
+	FVRiCCTraceQueueStats Stats;
+};
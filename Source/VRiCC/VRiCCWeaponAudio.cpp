@@ -0,0 +1,264 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCWeaponAudio.h"
+#include "TP_WeaponComponent.h"
+#include "VRiCC.h"
+#include "VRiCCStats.h"
+#include "Components/AudioComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Sound/SoundBase.h"
+
+static TAutoConsoleVariable<int32> CVarWeaponAudioMaxVoices(
+	TEXT("VRiCC.WeaponAudio.MaxVoices"),
+	24,
+	TEXT("Weapon sounds playing at once, closer sounds steal the voices of farther ones."));
+
+static TAutoConsoleVariable<int32> CVarWeaponAudioEmittersPerWeapon(
+	TEXT("VRiCC.WeaponAudio.EmittersPerWeapon"),
+	3,
+	TEXT("One shot emitters created per weapon, rapid shots reuse them round robin."));
+
+static TAutoConsoleVariable<float> CVarWeaponAudioMaxDistance(
+	TEXT("VRiCC.WeaponAudio.MaxDistance"),
+	10000.f,
+	TEXT("Weapon sounds farther than this from the listener are not played."));
+
+static TAutoConsoleVariable<float> CVarWeaponAudioDuplicateWindow(
+	TEXT("VRiCC.WeaponAudio.DuplicateWindow"),
+	0.03f,
+	TEXT("Seconds after a weapon sound starts during which the same sound nearby is culled as a duplicate."));
+
+static TAutoConsoleVariable<float> CVarWeaponAudioDuplicateRadius(
+	TEXT("VRiCC.WeaponAudio.DuplicateRadius"),
+	300.f,
+	TEXT("Distance within which the same weapon sound counts as a duplicate."));
+
+static FAutoConsoleCommandWithWorld GWeaponAudioStatsCommand(
+	TEXT("VRiCC.WeaponAudio.Stats"),
+	TEXT("Prints how many weapon sounds were played and how many the voice budget dropped."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		if (const UVRiCCWeaponAudioSubsystem* WeaponAudio = World != nullptr ? World->GetSubsystem<UVRiCCWeaponAudioSubsystem>() : nullptr)
+		{
+			const FVRiCCWeaponAudioStats& Stats = WeaponAudio->GetStats();
+			UE_LOG(LogTemp, Display, TEXT("WeaponAudio: played %llu, dropped distance %llu, duplicate %llu, budget %llu, stolen %llu, loops %llu, voices %d (peak %d)"),
+				Stats.Played, Stats.DroppedDistance, Stats.DroppedDuplicate, Stats.DroppedBudget, Stats.Stolen, Stats.Loops, WeaponAudio->GetNumVoices(), Stats.PeakVoices);
+		}
+	}));
+
+bool UVRiCCWeaponAudioSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+#if VRICC_WITH_PRESENTATION
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+#else
+	return false;
+#endif
+}
+
+bool UVRiCCWeaponAudioSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UVRiCCWeaponAudioSubsystem::RegisterWeapon(UTP_WeaponComponent* Weapon)
+{
+	// a PIE dedicated server still creates the subsystem, its weapons get no emitters and stay silent
+	if (Weapon == nullptr || Weapon->GetOwner() == nullptr || !VRiCC::IsPresentationEnabled(Weapon) || Weapons.Contains(Weapon))
+	{
+		return;
+	}
+
+	FWeaponEmitters& Emitters = Weapons.Add(Weapon);
+
+	auto CreateEmitter = [Weapon]()
+	{
+		UAudioComponent* Emitter = NewObject<UAudioComponent>(Weapon->GetOwner());
+		Emitter->bAutoActivate = false;
+		Emitter->bAutoDestroy = false;
+		Emitter->SetupAttachment(Weapon);
+		Emitter->RegisterComponent();
+		return Emitter;
+	};
+
+	const int32 NumOneShots = FMath::Max(CVarWeaponAudioEmittersPerWeapon.GetValueOnGameThread(), 1);
+	for (int32 Index = 0; Index < NumOneShots; ++Index)
+	{
+		Emitters.OneShots.Add(CreateEmitter());
+	}
+	Emitters.Loop = CreateEmitter();
+}
+
+void UVRiCCWeaponAudioSubsystem::UnregisterWeapon(UTP_WeaponComponent* Weapon)
+{
+	FWeaponEmitters Emitters;
+	if (!Weapons.RemoveAndCopyValue(Weapon, Emitters))
+	{
+		return;
+	}
+
+	Emitters.OneShots.Add(Emitters.Loop);
+	for (const TWeakObjectPtr<UAudioComponent>& Emitter : Emitters.OneShots)
+	{
+		if (UAudioComponent* AudioComponent = Emitter.Get())
+		{
+			AudioComponent->Stop();
+			AudioComponent->DestroyComponent();
+		}
+	}
+	PruneVoices();
+}
+
+void UVRiCCWeaponAudioSubsystem::PlaySound(UTP_WeaponComponent* Weapon, USoundBase* Sound, const FVector& Location)
+{
+	VRICC_SCOPE_CYCLE(WeaponAudio);
+
+	FWeaponEmitters* Emitters = Weapons.Find(Weapon);
+	if (Sound == nullptr || Emitters == nullptr || Emitters->OneShots.Num() == 0)
+	{
+		return;
+	}
+
+	// round robin, a rapid shot cuts off the oldest of the weapon's own voices instead of adding one
+	UAudioComponent* Emitter = Emitters->OneShots[Emitters->NextOneShot].Get();
+	Emitters->NextOneShot = (Emitters->NextOneShot + 1) % Emitters->OneShots.Num();
+	if (Emitter == nullptr || !AcquireVoice(Sound, Location, Emitter))
+	{
+		return;
+	}
+
+	Emitter->SetWorldLocation(Location);
+	Emitter->SetSound(Sound);
+	Emitter->Play();
+}
+
+void UVRiCCWeaponAudioSubsystem::StartFireLoop(UTP_WeaponComponent* Weapon, USoundBase* LoopSound)
+{
+	FWeaponEmitters* Emitters = Weapons.Find(Weapon);
+	UAudioComponent* Emitter = Emitters != nullptr ? Emitters->Loop.Get() : nullptr;
+	if (LoopSound == nullptr || Emitter == nullptr || Emitter->IsPlaying())
+	{
+		return;
+	}
+
+	if (!AcquireVoice(LoopSound, Weapon->GetComponentLocation(), Emitter))
+	{
+		return;
+	}
+
+	Stats.Loops++;
+	Emitter->SetSound(LoopSound);
+	Emitter->Play();
+}
+
+void UVRiCCWeaponAudioSubsystem::StopFireLoop(UTP_WeaponComponent* Weapon, USoundBase* TailSound)
+{
+	FWeaponEmitters* Emitters = Weapons.Find(Weapon);
+	UAudioComponent* Emitter = Emitters != nullptr ? Emitters->Loop.Get() : nullptr;
+	if (Emitter == nullptr || !Emitter->IsPlaying())
+	{
+		return;
+	}
+
+	Emitter->Stop();
+	PlaySound(Weapon, TailSound, Weapon->GetComponentLocation());
+}
+
+bool UVRiCCWeaponAudioSubsystem::IsFireLoopPlaying(const UTP_WeaponComponent* Weapon) const
+{
+	const FWeaponEmitters* Emitters = Weapons.Find(Weapon);
+	const UAudioComponent* Emitter = Emitters != nullptr ? Emitters->Loop.Get() : nullptr;
+	return Emitter != nullptr && Emitter->IsPlaying();
+}
+
+bool UVRiCCWeaponAudioSubsystem::AcquireVoice(const USoundBase* Sound, const FVector& Location, UAudioComponent* Emitter)
+{
+	PruneVoices();
+
+	const FVector ListenerLocation = GetListenerLocation();
+	const double DistanceSquared = FVector::DistSquared(Location, ListenerLocation);
+	if (DistanceSquared > FMath::Square(CVarWeaponAudioMaxDistance.GetValueOnGameThread()))
+	{
+		Stats.DroppedDistance++;
+		return false;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double DuplicateWindow = CVarWeaponAudioDuplicateWindow.GetValueOnGameThread();
+	const double DuplicateRadiusSquared = FMath::Square(CVarWeaponAudioDuplicateRadius.GetValueOnGameThread());
+
+	// a restarted emitter hands its old voice over to the new sound once that is accepted, until then it keeps counting
+	int32 OwnIndex = INDEX_NONE;
+	int32 FarthestIndex = INDEX_NONE;
+	double FarthestDistanceSquared = DistanceSquared;
+	for (int32 Index = 0; Index < Voices.Num(); ++Index)
+	{
+		const FVoice& Voice = Voices[Index];
+		if (Voice.Emitter.Get() == Emitter)
+		{
+			OwnIndex = Index;
+			continue;
+		}
+
+		if (Voice.Sound == Sound && Now - Voice.StartTime < DuplicateWindow && FVector::DistSquared(Voice.Location, Location) < DuplicateRadiusSquared)
+		{
+			Stats.DroppedDuplicate++;
+			return false;
+		}
+
+		const double VoiceDistanceSquared = FVector::DistSquared(Voice.Location, ListenerLocation);
+		if (VoiceDistanceSquared > FarthestDistanceSquared)
+		{
+			FarthestDistanceSquared = VoiceDistanceSquared;
+			FarthestIndex = Index;
+		}
+	}
+
+	if (OwnIndex == INDEX_NONE && Voices.Num() >= FMath::Max(CVarWeaponAudioMaxVoices.GetValueOnGameThread(), 1))
+	{
+		if (FarthestIndex == INDEX_NONE)
+		{
+			Stats.DroppedBudget++;
+			return false;
+		}
+
+		if (UAudioComponent* Stolen = Voices[FarthestIndex].Emitter.Get())
+		{
+			Stolen->Stop();
+		}
+		Voices.RemoveAtSwap(FarthestIndex);
+		Stats.Stolen++;
+	}
+
+	FVoice& Voice = OwnIndex != INDEX_NONE ? Voices[OwnIndex] : Voices.AddDefaulted_GetRef();
+	Voice.Emitter = Emitter;
+	Voice.Sound = Sound;
+	Voice.Location = Location;
+	Voice.StartTime = Now;
+
+	Stats.Played++;
+	Stats.PeakVoices = FMath::Max(Stats.PeakVoices, Voices.Num());
+	return true;
+}
+
+void UVRiCCWeaponAudioSubsystem::PruneVoices()
+{
+	Voices.RemoveAllSwap([](const FVoice& Voice)
+	{
+		const UAudioComponent* Emitter = Voice.Emitter.Get();
+		return Emitter == nullptr || !Emitter->IsPlaying();
+	});
+}
+
+FVector UVRiCCWeaponAudioSubsystem::GetListenerLocation() const
+{
+	FVector Location = FVector::ZeroVector;
+	FVector FrontDir;
+	FVector RightDir;
+	if (const APlayerController* PlayerController = GetWorld()->GetFirstPlayerController())
+	{
+		PlayerController->GetAudioListenerPosition(Location, FrontDir, RightDir);
+	}
+	return Location;
+}
@@ -0,0 +1,94 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "VRiCCWeaponAudio.generated.h"
+
+class UAudioComponent;
+class USoundBase;
+class UTP_WeaponComponent;
+
+/** Counters of the weapon audio manager, for VRiCC.WeaponAudio.Stats */
+struct FVRiCCWeaponAudioStats
+{
+	uint64 Played = 0;
+	/** Farther from the listener than VRiCC.WeaponAudio.MaxDistance */
+	uint64 DroppedDistance = 0;
+	/** Same sound started close by a moment ago */
+	uint64 DroppedDuplicate = 0;
+	/** Voice budget full of closer sounds */
+	uint64 DroppedBudget = 0;
+	/** Farther voices stopped to make room for a closer one */
+	uint64 Stolen = 0;
+	/** Automatic fire bursts played as one loop instead of a voice per shot */
+	uint64 Loops = 0;
+	int32 PeakVoices = 0;
+};
+
+/**
+ * Plays weapon sounds through emitters created once per weapon instead of a new audio component per shot.
+ * A global voice budget culls gunshots that are too far, duplicates of a sound that just started nearby,
+ * and, once the budget is full, the farthest voices. Automatic fire can run as one looped emitter with a tail.
+ * Not created on dedicated servers and compiled out of the server target.
+ */
+UCLASS()
+class VRICC_API UVRiCCWeaponAudioSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Creates the emitters of a weapon, called when it is attached */
+	void RegisterWeapon(UTP_WeaponComponent* Weapon);
+	void UnregisterWeapon(UTP_WeaponComponent* Weapon);
+
+	/** One shot sound of Weapon at Location, unless the voice budget culls it */
+	void PlaySound(UTP_WeaponComponent* Weapon, USoundBase* Sound, const FVector& Location);
+
+	/** Starts LoopSound on the weapon's loop emitter if it is not playing yet */
+	void StartFireLoop(UTP_WeaponComponent* Weapon, USoundBase* LoopSound);
+
+	/** Stops the loop of Weapon and plays TailSound in its place */
+	void StopFireLoop(UTP_WeaponComponent* Weapon, USoundBase* TailSound);
+
+	bool IsFireLoopPlaying(const UTP_WeaponComponent* Weapon) const;
+
+	const FVRiCCWeaponAudioStats& GetStats() const { return Stats; }
+	int32 GetNumVoices() const { return Voices.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FWeaponEmitters
+	{
+		TArray<TWeakObjectPtr<UAudioComponent>> OneShots;
+		int32 NextOneShot = 0;
+		TWeakObjectPtr<UAudioComponent> Loop;
+	};
+
+	struct FVoice
+	{
+		TWeakObjectPtr<UAudioComponent> Emitter;
+		const USoundBase* Sound = nullptr;
+		FVector Location = FVector::ZeroVector;
+		double StartTime = 0.0;
+	};
+
+	/** Takes a voice for Sound at Location out of the budget, false if the sound should not play */
+	bool AcquireVoice(const USoundBase* Sound, const FVector& Location, UAudioComponent* Emitter);
+
+	/** Forgets voices whose emitters finished */
+	void PruneVoices();
+
+	FVector GetListenerLocation() const;
+
+	TMap<TObjectKey<UTP_WeaponComponent>, FWeaponEmitters> Weapons;
+	TArray<FVoice> Voices;
+
+	FVRiCCWeaponAudioStats Stats;
+};
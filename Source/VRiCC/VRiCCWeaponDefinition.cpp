@@ -0,0 +1,73 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "VRiCCWeaponDefinition.h"
+#include "Animation/AnimMontage.h"
+#include "Sound/SoundBase.h"
+
+const FPrimaryAssetType UVRiCCWeaponDefinition::PrimaryAssetType(TEXT("VRiCCWeapon"));
+
+TArray<FVRiCCWeaponStats> FVRiCCWeaponTable::Stats = { FVRiCCWeaponStats() };
+TArray<TWeakObjectPtr<const UVRiCCWeaponDefinition>> FVRiCCWeaponTable::Definitions = { nullptr };
+
+FPrimaryAssetId UVRiCCWeaponDefinition::GetPrimaryAssetId() const
+{
+	return FPrimaryAssetId(PrimaryAssetType, GetFName());
+}
+
+#if WITH_EDITOR
+void UVRiCCWeaponDefinition::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	FVRiCCWeaponTable::Recompile(this);
+}
+#endif
+
+FVRiCCWeaponStats UVRiCCWeaponDefinition::CompileStats() const
+{
+	FVRiCCWeaponStats Compiled;
+	Compiled.RoundsPerMinute = FMath::Max(RoundsPerMinute, 1.f);
+	Compiled.ShotInterval = 60.f / Compiled.RoundsPerMinute;
+	Compiled.TraceLength = TraceLength;
+	Compiled.Damage = Damage;
+	Compiled.HitImpulse = HitImpulse;
+	Compiled.ReloadSeconds = ReloadSeconds;
+	Compiled.ShotsPerRack = FMath::Clamp(ShotsPerRack, 1, 127);
+	Compiled.AmmoRacks = FMath::Clamp(AmmoRacks, 0, 31);
+	return Compiled;
+}
+
+uint16 FVRiCCWeaponTable::FindOrAdd(const UVRiCCWeaponDefinition* Definition)
+{
+	check(IsInGameThread());
+
+	if (Definition == nullptr)
+	{
+		return DefaultWeaponId;
+	}
+
+	for (int32 Index = 1; Index < Definitions.Num(); ++Index)
+	{
+		if (Definitions[Index] == Definition)
+		{
+			return uint16(Index);
+		}
+	}
+
+	// ids are never reused, a definition that unloads keeps its compiled stats
+	check(Stats.Num() < MAX_uint16);
+	Definitions.Add(Definition);
+	return uint16(Stats.Add(Definition->CompileStats()));
+}
+
+void FVRiCCWeaponTable::Recompile(const UVRiCCWeaponDefinition* Definition)
+{
+	for (int32 Index = 1; Index < Definitions.Num(); ++Index)
+	{
+		if (Definitions[Index] == Definition)
+		{
+			Stats[Index] = Definition->CompileStats();
+			return;
+		}
+	}
+}
@@ -0,0 +1,116 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "VRiCCWeaponDefinition.generated.h"
+
+class UAnimMontage;
+class USoundBase;
+
+/** Tuning of one weapon as the fire path reads it, the defaults are the built-in rifle */
+struct FVRiCCWeaponStats
+{
+	float RoundsPerMinute = 120.f;
+	/** Seconds between automatic shots, 60 / RoundsPerMinute */
+	float ShotInterval = 0.5f;
+	float TraceLength = 1000.f;
+	float Damage = 0.1f;
+	/** Pushed into a simulating body a shot hits */
+	float HitImpulse = 100000.f;
+	float ReloadSeconds = 1.f;
+	int32 ShotsPerRack = 8;
+	int32 AmmoRacks = 4;
+};
+
+/**
+ * Data asset describing a weapon: its tuning, compiled into FVRiCCWeaponTable when it loads, and soft
+ * references to its sounds and animation in the Cosmetic bundle, streamed in when the weapon is first picked up.
+ * Scanned by the asset manager as primary asset type VRiCCWeapon under /Game/Weapons.
+ */
+UCLASS(BlueprintType)
+class VRICC_API UVRiCCWeaponDefinition : public UPrimaryDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	static const FPrimaryAssetType PrimaryAssetType;
+
+	// UObject interface
+	virtual FPrimaryAssetId GetPrimaryAssetId() const override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+	// End of UObject interface
+
+	FVRiCCWeaponStats CompileStats() const;
+
+	/** Automatic fire rate, shots due within a frame are fired together with their own sub-frame times */
+	UPROPERTY(EditDefaultsOnly, Category = "Firing", meta = (ClampMin = "1"))
+	float RoundsPerMinute = 120.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Firing", meta = (ClampMin = "1"))
+	float TraceLength = 1000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Firing", meta = (ClampMin = "0"))
+	float Damage = 0.1f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Firing", meta = (ClampMin = "0"))
+	float HitImpulse = 100000.f;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Ammo", meta = (ClampMin = "0"))
+	float ReloadSeconds = 1.f;
+
+	/** Limited by the bits the combat state replicates ammo with */
+	UPROPERTY(EditDefaultsOnly, Category = "Ammo", meta = (ClampMin = "1", ClampMax = "127"))
+	int32 ShotsPerRack = 8;
+
+	/** Racks a character carries after picking the weapon up */
+	UPROPERTY(EditDefaultsOnly, Category = "Ammo", meta = (ClampMin = "0", ClampMax = "31"))
+	int32 AmmoRacks = 4;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Cosmetic", meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> FireSound;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Cosmetic", meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> ReloadSound;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Cosmetic", meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> EmptySound;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Cosmetic", meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> FireLoopSound;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Cosmetic", meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<USoundBase> FireTailSound;
+
+	UPROPERTY(EditDefaultsOnly, Category = "Cosmetic", meta = (AssetBundles = "Cosmetic"))
+	TSoftObjectPtr<UAnimMontage> FireAnimation;
+};
+
+/**
+ * Compiled stats of every loaded weapon definition in one flat array, indexed by weapon id.
+ * Id 0 is the built-in rifle for weapons without a definition. Game thread only.
+ */
+class VRICC_API FVRiCCWeaponTable
+{
+public:
+	static constexpr uint16 DefaultWeaponId = 0;
+
+	/** Compiles Definition the first time it is seen, null gets the default weapon */
+	static uint16 FindOrAdd(const UVRiCCWeaponDefinition* Definition);
+
+	/** Compiles Definition again, for edits made while the game runs */
+	static void Recompile(const UVRiCCWeaponDefinition* Definition);
+
+	static const FVRiCCWeaponStats& Get(uint16 WeaponId) { return Stats[WeaponId]; }
+
+	static int32 Num() { return Stats.Num(); }
+
+private:
+	static TArray<FVRiCCWeaponStats> Stats;
+
+	/** Indexed like Stats, null for the default weapon */
+	static TArray<TWeakObjectPtr<const UVRiCCWeaponDefinition>> Definitions;
+};
@@ -2,26 +2,118 @@
 
 
 #include "WeaponSpawner.h"
+#include "TP_PickUpComponent.h"
 
 // Sets default values
 AWeaponSpawner::AWeaponSpawner()
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Spawners never tick, respawn and cooldown are events scheduled on the spawner registry
+	PrimaryActorTick.bCanEverTick = false;
 
+	// Spawners only replicate when a pick up or respawn changes them
+	NetDormancy = DORM_Initial;
+
+	RespawnDelay = 0.f;
+	CooldownTime = 0.f;
+	bCoolingDown = false;
 }
 
 // Called when the game starts or when spawned
 void AWeaponSpawner::BeginPlay()
 {
 	Super::BeginPlay();
-	
+
+	if (UVRiCCSpawnerRegistry* SpawnerRegistry = GetWorld()->GetSubsystem<UVRiCCSpawnerRegistry>())
+	{
+		SpawnerHandle = SpawnerRegistry->Register(this);
+	}
+}
+
+void AWeaponSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UVRiCCSpawnerRegistry* SpawnerRegistry = GetWorld()->GetSubsystem<UVRiCCSpawnerRegistry>())
+	{
+		SpawnerRegistry->CancelEvent(RespawnTimer);
+		SpawnerRegistry->CancelEvent(CooldownTimer);
+		SpawnerRegistry->Unregister(SpawnerHandle);
+	}
+	SpawnerHandle.Invalidate();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+AActor* AWeaponSpawner::SpawnWeapon()
+{
+	if (WeaponClass == nullptr)
+	{
+		return nullptr;
+	}
+
+	if (HasAuthority())
+	{
+		FlushNetDormancy();
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AActor* Weapon = GetWorld()->SpawnActor<AActor>(WeaponClass, GetActorTransform(), SpawnParams);
+	if (Weapon != nullptr)
+	{
+		TInlineComponentArray<UTP_PickUpComponent*> PickUps(Weapon);
+		for (UTP_PickUpComponent* PickUp : PickUps)
+		{
+			PickUp->SetSpawnerHandle(SpawnerHandle);
+		}
+	}
+	return Weapon;
+}
+
+void AWeaponSpawner::NotifyPickedUp()
+{
+	if (HasAuthority())
+	{
+		FlushNetDormancy();
+	}
+
+	OnPickUpWeapon.Broadcast();
+
+	UVRiCCSpawnerRegistry* SpawnerRegistry = GetWorld()->GetSubsystem<UVRiCCSpawnerRegistry>();
+	if (SpawnerRegistry == nullptr)
+	{
+		return;
+	}
+
+	// weapons only exist on the server, clients just get the cooldown state
+	if (RespawnDelay > 0.f && HasAuthority())
+	{
+		SpawnerRegistry->CancelEvent(RespawnTimer);
+		RespawnTimer = SpawnerRegistry->ScheduleEvent(SpawnerHandle, EVRiCCSpawnerEvent::Respawn, RespawnDelay);
+	}
+
+	if (CooldownTime > 0.f)
+	{
+		bCoolingDown = true;
+		SpawnerRegistry->CancelEvent(CooldownTimer);
+		CooldownTimer = SpawnerRegistry->ScheduleEvent(SpawnerHandle, EVRiCCSpawnerEvent::CooldownFinished, CooldownTime);
+	}
 }
 
-// Called every frame
-void AWeaponSpawner::Tick(float DeltaTime)
+void AWeaponSpawner::HandleSpawnerEvent(EVRiCCSpawnerEvent Event)
 {
-	Super::Tick(DeltaTime);
+	switch (Event)
+	{
+	case EVRiCCSpawnerEvent::Respawn:
+		RespawnTimer.Invalidate();
+		SpawnWeapon();
+		break;
 
+	case EVRiCCSpawnerEvent::CooldownFinished:
+		CooldownTimer.Invalidate();
+		bCoolingDown = false;
+		OnCooldownFinished.Broadcast();
+		break;
+	}
 }
 
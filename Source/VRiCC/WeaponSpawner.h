@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "VRiCCSpawnerRegistry.h"
 #include "WeaponSpawner.generated.h"
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnPickUpWeapon);
@@ -23,13 +24,44 @@ public:
 	UPROPERTY(BlueprintAssignable, Category = "Weapon")
 	FOnPickUpWeapon OnPickUpWeapon;
 
+	/** Seconds after a pick up until WeaponClass is spawned again, 0 leaves respawning to blueprint */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon", meta = (ClampMin = "0"))
+	float RespawnDelay;
+
+	/** Seconds after a pick up during which the spawner reports it is cooling down */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Weapon", meta = (ClampMin = "0"))
+	float CooldownTime;
+
+	UPROPERTY(BlueprintAssignable, Category = "Weapon")
+	FOnPickUpWeapon OnCooldownFinished;
+
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	bool IsCoolingDown() const { return bCoolingDown; }
+
+	/** Called by the pickup component: broadcasts OnPickUpWeapon and schedules respawn and cooldown */
+	void NotifyPickedUp();
+
+	/** Called by the spawner registry when one of our scheduled events is due */
+	void HandleSpawnerEvent(EVRiCCSpawnerEvent Event);
+
+	/** Spawns WeaponClass on this spawner and links its pickup components back to it */
+	UFUNCTION(BlueprintCallable, Category = "Weapon")
+	AActor* SpawnWeapon();
+
+	/** Handle pickups use to find this spawner through the spawner registry */
+	const FVRiCCSpawnerHandle& GetSpawnerHandle() const { return SpawnerHandle; }
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+private:
+	FVRiCCSpawnerHandle SpawnerHandle;
+
+	FVRiCCTimerWheelHandle RespawnTimer;
+	FVRiCCTimerWheelHandle CooldownTimer;
 
+	bool bCoolingDown;
 };